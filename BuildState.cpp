@@ -0,0 +1,531 @@
+#include "BuildState.h"
+
+/*
+    .siteinfo/build.state format:
+
+    "nsm-build-state 5\n" followed by records, each a 4 byte payload size,
+    a 1 byte type and the payload:
+
+    'P' path:    path, paths get ids 0, 1, .. in the order they appear
+    'B' built:   page-name info-size info-mtime output-hash page-size page-mtime
+                 page-title template-id no-deps followed by
+                 dep-id dep-size dep-mtime dep-hash dep-parent for each
+                 dep (dep-parent is the position in the page's deps of the
+                 file it was read from, -1 if none), then
+                 no-refs followed by ref-name ref-path-id for each page
+                 linked to with @pathto/@pathtopage, then no-keys followed
+                 by key value for each config key read (eg. with @sitedir)
+    'R' removed: page-name
+    'C' clear:   (no payload) paths get ids from 0 again, later records
+                 only use paths recorded after it
+
+    strings are a 4 byte length followed by their characters, ids and
+    counts are 4 bytes, sizes, times and hashes 8 bytes, all in native
+    byte order. info-size and info-mtime are from the page's info file
+    for pages carried over from one, otherwise 0 and when it was built.
+    a record which was cut short (eg. nsm being killed while saving)
+    ends the log. version 1 logs (without output-hash and the page stamp),
+    version 2 logs (without refs), version 3 logs (without keys),
+    version 4 logs (without dep-parent) and version 5 logs (without
+    clear records) are still read, and rewritten as version 6 when next
+    saved
+*/
+
+const char* buildStatePath = ".siteinfo/build.state";
+const int buildStateVersion = 6;
+const std::string buildStateHeader = "nsm-build-state " + std::to_string(buildStateVersion) + "\n";
+
+//what has been read from the build state
+struct BuildStateLog
+{
+    std::map<Name, DepIndexEntry> pages;
+    MappedIndex* mapped; //when set just where records are is kept, rather than pages and paths
+    std::vector<Path> paths;
+    std::unordered_map<Path, unsigned int> pathIDs;
+    size_t fileSize, validSize, noRecords;
+    int version;
+
+    BuildStateLog() : mapped(NULL) {}
+};
+
+struct LogReader
+{
+    const char* pos;
+    const char* end;
+
+    template <class T>
+    bool read(T& val)
+    {
+        if((size_t)(end - pos) < sizeof(T))
+            return 0;
+        memcpy(&val, pos, sizeof(T));
+        pos += sizeof(T);
+        return 1;
+    }
+
+    bool read(std::string& str)
+    {
+        unsigned int length;
+        if(!read(length) || (size_t)(end - pos) < length)
+            return 0;
+        str.assign(pos, length);
+        pos += length;
+        return 1;
+    }
+};
+
+template <class T>
+void put(std::string& buf, const T& val)
+{
+    buf.append((const char*)&val, sizeof(T));
+}
+
+void put(std::string& buf, const std::string& str)
+{
+    put(buf, (unsigned int)str.size());
+    buf += str;
+}
+
+void put_record(std::string& buf, const char& type, const std::string& payload)
+{
+    put(buf, (unsigned int)payload.size());
+    buf += type;
+    buf += payload;
+}
+
+unsigned int path_id(std::string& buf, const Path& path, std::unordered_map<Path, unsigned int>& pathIDs)
+{
+    auto pathID = pathIDs.find(path);
+    if(pathID != pathIDs.end())
+        return pathID->second;
+
+    std::string payload;
+    put(payload, path.str());
+    put_record(buf, 'P', payload);
+
+    unsigned int id = pathIDs.size();
+    pathIDs[path] = id;
+
+    return id;
+}
+
+//adds a record for a built page to buf, preceded by records for any paths without ids yet
+void put_entry(std::string& buf, const Name& pageName, const DepIndexEntry& entry, std::unordered_map<Path, unsigned int>& pathIDs)
+{
+    std::string payload;
+    put(payload, pageName);
+    put(payload, entry.infoStamp.first);
+    put(payload, entry.infoStamp.second);
+    put(payload, entry.outputHash);
+    put(payload, entry.pageStamp.first);
+    put(payload, entry.pageStamp.second);
+    put(payload, entry.pageTitle.str);
+    put(payload, path_id(buf, entry.templatePath, pathIDs));
+    put(payload, (unsigned int)entry.deps.size());
+    for(size_t d=0; d<entry.deps.size(); d++)
+    {
+        put(payload, path_id(buf, entry.deps[d], pathIDs));
+        put(payload, entry.depStamps[d].stamp.first);
+        put(payload, entry.depStamps[d].stamp.second);
+        put(payload, entry.depStamps[d].hash);
+        put(payload, (int)(d < entry.depParents.size() ? entry.depParents[d] : -1));
+    }
+    put(payload, (unsigned int)entry.pageRefs.size());
+    for(size_t r=0; r<entry.pageRefs.size(); r++)
+    {
+        put(payload, entry.pageRefs[r].first);
+        put(payload, path_id(buf, entry.pageRefs[r].second, pathIDs));
+    }
+    put(payload, (unsigned int)entry.configDeps.size());
+    for(size_t k=0; k<entry.configDeps.size(); k++)
+    {
+        put(payload, entry.configDeps[k].first);
+        put(payload, entry.configDeps[k].second);
+    }
+
+    put_record(buf, 'B', payload);
+}
+
+bool find_path(const std::vector<Path>& paths, const unsigned int& id, Path& path)
+{
+    if(id >= paths.size())
+        return 0;
+    path = paths[id];
+
+    return 1;
+}
+
+//paths of a mapped build state from its 'P' records, as they're needed
+struct MappedPaths
+{
+    const MappedFile* file;
+    const size_t* offsets;
+    size_t noPaths;
+};
+
+bool find_path(const MappedPaths& paths, const unsigned int& id, Path& path)
+{
+    LogReader reader;
+    std::string str;
+
+    if(id >= paths.noPaths)
+        return 0;
+    reader.pos = paths.file->data + paths.offsets[id] + 5;
+    reader.end = paths.file->data + paths.file->size;
+    if(!reader.read(str))
+        return 0;
+    path.set_file_path_from(str);
+
+    return 1;
+}
+
+//reads the payload of a 'B' record
+template <class Paths>
+bool read_built(LogReader& reader, const Paths& paths, const int& version, std::string& pageName, DepIndexEntry& entry)
+{
+    unsigned int id, noDeps, noRefs, noKeys;
+
+    if(!reader.read(pageName) ||
+       !reader.read(entry.infoStamp.first) ||
+       !reader.read(entry.infoStamp.second) ||
+       (version > 1 && (!reader.read(entry.outputHash) || !reader.read(entry.pageStamp.first) || !reader.read(entry.pageStamp.second))) ||
+       !reader.read(entry.pageTitle.str) ||
+       !reader.read(id) || !find_path(paths, id, entry.templatePath) ||
+       !reader.read(noDeps))
+        return 0;
+
+    entry.deps.resize(noDeps);
+    entry.depStamps.resize(noDeps);
+    entry.depParents.resize(noDeps, -1);
+    for(unsigned int d=0; d<noDeps; d++)
+    {
+        if(!reader.read(id) || !find_path(paths, id, entry.deps[d]) ||
+           !reader.read(entry.depStamps[d].stamp.first) ||
+           !reader.read(entry.depStamps[d].stamp.second) ||
+           !reader.read(entry.depStamps[d].hash) ||
+           (version > 4 && !reader.read(entry.depParents[d])))
+            return 0;
+    }
+
+    if(version > 2)
+    {
+        if(!reader.read(noRefs))
+            return 0;
+        entry.pageRefs.resize(noRefs);
+        for(unsigned int r=0; r<noRefs; r++)
+        {
+            if(!reader.read(entry.pageRefs[r].first) || !reader.read(id) || !find_path(paths, id, entry.pageRefs[r].second))
+                return 0;
+        }
+    }
+
+    if(version > 3)
+    {
+        if(!reader.read(noKeys))
+            return 0;
+        entry.configDeps.resize(noKeys);
+        for(unsigned int k=0; k<noKeys; k++)
+            if(!reader.read(entry.configDeps[k].first) || !reader.read(entry.configDeps[k].second))
+                return 0;
+    }
+
+    return 1;
+}
+
+//parses the record starting at offset in the build state
+bool parse_record(const char& type, const size_t& offset, LogReader& reader, BuildStateLog& log)
+{
+    std::string str;
+
+    if(type == 'P')
+    {
+        Path path;
+        if(!reader.read(str))
+            return 0;
+        if(log.mapped)
+            log.mapped->pathOffsets.push_back(offset);
+        else
+        {
+            path.set_file_path_from(str);
+            log.pathIDs.insert(std::make_pair(path, log.paths.size()));
+            log.paths.push_back(path);
+        }
+    }
+    else if(type == 'B' && !log.mapped)
+    {
+        DepIndexEntry entry;
+        if(!read_built(reader, log.paths, log.version, str, entry))
+            return 0;
+        log.pages[str] = entry;
+        log.noRecords++;
+    }
+    else if(type == 'B' || type == 'R')
+    {
+        if(!reader.read(str))
+            return 0;
+        //the rest of the record is only read when it's needed, which of a page's records is its latest is worked out once all are found
+        if(log.mapped)
+            log.mapped->offsets.push_back(offset);
+        else
+            log.pages.erase(str);
+        log.noRecords++;
+    }
+    else if(type == 'C')
+    {
+        if(log.mapped)
+            log.mapped->pathBlocks.push_back(std::make_pair(offset, log.mapped->pathOffsets.size()));
+        else
+        {
+            log.paths.clear();
+            log.pathIDs.clear();
+        }
+    }
+    else
+        return 0;
+
+    return 1;
+}
+
+bool parse_build_state(const char* data, const size_t& size, BuildStateLog& log)
+{
+    log.fileSize = size;
+    log.validSize = 0;
+    log.noRecords = 0;
+
+    if(size < buildStateHeader.size())
+        return 0;
+
+    //older versions have headers of the same length
+    log.version = 0;
+    for(int v=1; v<=buildStateVersion; v++)
+        if(!memcmp(data, ("nsm-build-state " + std::to_string(v) + "\n").c_str(), buildStateHeader.size()))
+            log.version = v;
+    if(!log.version)
+        return 0;
+
+    const char *pos = data + buildStateHeader.size(),
+               *end = data + size;
+    unsigned int payloadSize;
+    LogReader reader;
+
+    log.validSize = buildStateHeader.size();
+    while(end - pos >= 5)
+    {
+        memcpy(&payloadSize, pos, 4);
+        if((size_t)(end - pos - 5) < payloadSize)
+            break;
+
+        reader.pos = pos + 5;
+        reader.end = pos + 5 + payloadSize;
+        if(!parse_record(pos[4], pos - data, reader, log))
+            break;
+
+        pos = reader.end;
+        log.validSize = pos - data;
+    }
+
+    return 1;
+}
+
+//returns 1 if there isn't a readable build state
+int read_log(BuildStateLog& log)
+{
+    MappedFile file;
+    if(file.open(buildStatePath))
+        return 1;
+
+    return !parse_build_state(file.data, file.size, log);
+}
+
+int read_build_state(std::map<Name, DepIndexEntry>& pages)
+{
+    BuildStateLog log;
+
+    if(read_log(log))
+        return 1;
+
+    pages.swap(log.pages);
+
+    return 0;
+}
+
+int save_build_state(const std::map<Name, DepIndexEntry>& pages,
+                     const std::set<Name>& updatedPages,
+                     const std::set<Name>& removedPages,
+                     const PageSet* trackedPages,
+                     std::map<Name, DepIndexEntry>* savedPages,
+                     std::pair<long long int, long long int>* savedStamp)
+{
+    int lockFD = lock_file(".siteinfo/build.state.lock");
+
+    //rereads the log as other processes (eg. build shards) may have added to it
+    BuildStateLog log;
+    bool compact = read_log(log) || log.validSize != log.fileSize || log.version != buildStateVersion;
+
+    std::string records;
+    for(auto pageName=removedPages.begin(); pageName!=removedPages.end(); pageName++)
+    {
+        if(log.pages.count(*pageName))
+        {
+            std::string payload;
+            put(payload, *pageName);
+            put_record(records, 'R', payload);
+            log.pages.erase(*pageName);
+            log.noRecords++;
+        }
+    }
+    for(auto pageName=updatedPages.begin(); pageName!=updatedPages.end(); pageName++)
+    {
+        const DepIndexEntry& entry = pages.at(*pageName);
+        put_entry(records, *pageName, entry, log.pathIDs);
+        log.pages[*pageName] = entry;
+        log.noRecords++;
+    }
+
+    //compacts the log once most of its records are out of date
+    std::set<Name> trackedNames;
+    if(trackedPages)
+        for(auto page=trackedPages->begin(); page!=trackedPages->end(); page++)
+            trackedNames.insert(trackedNames.end(), page->pageName);
+    if(log.noRecords > 2*(trackedPages ? trackedNames.size() : log.pages.size()) + 256)
+        compact = 1;
+
+    if(compact)
+    {
+        std::unordered_map<Path, unsigned int> pathIDs;
+        std::string compacted = buildStateHeader;
+        for(auto page=log.pages.begin(); page!=log.pages.end();)
+        {
+            if(!trackedPages || trackedNames.count(page->first))
+            {
+                put_entry(compacted, page->first, page->second, pathIDs);
+                page++;
+            }
+            else
+                page = log.pages.erase(page);
+        }
+
+        std::ofstream ofs(".siteinfo/build.state.tmp", std::ios::binary);
+        ofs.write(compacted.c_str(), compacted.size());
+        ofs.close();
+
+        #if defined _WIN32 || defined _WIN64
+            std::remove(buildStatePath);
+        #endif
+        std::rename(".siteinfo/build.state.tmp", buildStatePath);
+    }
+    else if(records.size())
+    {
+        std::ofstream ofs(buildStatePath, std::ios::binary | std::ios::app);
+        ofs.write(records.c_str(), records.size());
+        ofs.close();
+    }
+
+    if(savedPages)
+    {
+        savedPages->swap(log.pages);
+        *savedStamp = file_stamp(buildStatePath);
+    }
+
+    unlock_file(lockFD, ".siteinfo/build.state.lock");
+
+    return 0;
+}
+
+int forget_built_pages(const std::set<Name>& pageNames, const PageSet& trackedPages)
+{
+    if(!std::ifstream(buildStatePath))
+        return 0;
+
+    return save_build_state(std::map<Name, DepIndexEntry>(), std::set<Name>(), pageNames, &trackedPages, NULL, NULL);
+}
+
+int forget_built_page(const Name& pageName, const PageSet& trackedPages)
+{
+    std::set<Name> pageNames;
+    pageNames.insert(pageName);
+
+    return forget_built_pages(pageNames, trackedPages);
+}
+
+//page name of the 'B' or 'R' record at offset, which was checked when the build state was scanned
+std::string record_name(const MappedFile& file, const size_t& offset)
+{
+    unsigned int length;
+    memcpy(&length, file.data + offset + 5, 4);
+
+    return std::string(file.data + offset + 9, length);
+}
+
+int scan_build_state(MappedIndex& mapped)
+{
+    BuildStateLog log;
+    log.mapped = &mapped;
+
+    mapped.offsets.clear();
+    mapped.pathOffsets.clear();
+    mapped.pathBlocks.assign(1, std::make_pair((size_t)0, (size_t)0));
+    if(!mapped.file.data || !parse_build_state(mapped.file.data, mapped.file.size, log))
+    {
+        mapped.offsets.clear();
+        mapped.pathOffsets.clear();
+        return 1;
+    }
+    mapped.version = log.version;
+
+    //sorts the records by page name (keeping them in the order they were added), then keeps each page's latest record unless it removed the page
+    const MappedFile& file = mapped.file;
+    std::stable_sort(mapped.offsets.begin(), mapped.offsets.end(),
+        [&file](const size_t& a, const size_t& b) { return record_name(file, a) < record_name(file, b); });
+    size_t noLatest = 0;
+    for(size_t r=0; r<mapped.offsets.size(); r++)
+        if((r+1 == mapped.offsets.size() || record_name(file, mapped.offsets[r]) != record_name(file, mapped.offsets[r+1])) &&
+           file.data[mapped.offsets[r] + 4] == 'B')
+            mapped.offsets[noLatest++] = mapped.offsets[r];
+    mapped.offsets.resize(noLatest);
+    mapped.offsets.shrink_to_fit();
+
+    return 0;
+}
+
+bool read_built_entry(const MappedIndex& mapped, const Name& pageName, DepIndexEntry& entry)
+{
+    const MappedFile& file = mapped.file;
+    auto offset = std::lower_bound(mapped.offsets.begin(), mapped.offsets.end(), pageName,
+        [&file](const size_t& a, const Name& name) { return record_name(file, a) < name; });
+    if(offset == mapped.offsets.end() || record_name(file, *offset) != pageName)
+        return 0;
+
+    //the record's path ids are of the paths since ids last started again
+    auto block = std::upper_bound(mapped.pathBlocks.begin(), mapped.pathBlocks.end(), std::make_pair(*offset, std::string::npos)) - 1;
+    MappedPaths paths;
+    paths.file = &file;
+    paths.offsets = mapped.pathOffsets.data() + block->second;
+    paths.noPaths = (block+1 == mapped.pathBlocks.end() ? mapped.pathOffsets.size() : (block+1)->second) - block->second;
+
+    unsigned int payloadSize;
+    std::string name;
+    LogReader reader;
+    memcpy(&payloadSize, file.data + *offset, 4);
+    reader.pos = file.data + *offset + 5;
+    reader.end = reader.pos + payloadSize;
+
+    return read_built(reader, paths, mapped.version, name, entry);
+}
+
+void write_build_state_header(std::ostream& ofs)
+{
+    ofs.write(buildStateHeader.c_str(), buildStateHeader.size());
+}
+
+void write_built_batch(std::ostream& ofs, const std::map<Name, DepIndexEntry>& pages)
+{
+    std::unordered_map<Path, unsigned int> pathIDs;
+    std::string records;
+
+    put_record(records, 'C', "");
+    for(auto page=pages.begin(); page!=pages.end(); page++)
+        put_entry(records, page->first, page->second, pathIDs);
+
+    ofs.write(records.c_str(), records.size());
+}
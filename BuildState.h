@@ -0,0 +1,51 @@
+#ifndef BUILD_STATE_H_
+#define BUILD_STATE_H_
+
+#include <cstdio>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "DepIndex.h"
+
+/*
+    .siteinfo/build.state keeps what would otherwise go in every page's
+    info file in a single binary file, enabled with 'buildState 1' in the
+    config file. it is an append-only log of records, later records for
+    a page replacing earlier ones, which is compacted once it is mostly
+    out of date records
+*/
+
+//reads the build state in to pages, returns 1 if there isn't a readable build state
+int read_build_state(std::map<Name, DepIndexEntry>& pages);
+
+//appends records for the updated pages and removals for the removed pages to the build state,
+//compacting keeps every page's records when trackedPages is NULL, savedPages (if not NULL) is
+//left with the build state as saved and savedStamp with the stamp of the saved file
+int save_build_state(const std::map<Name, DepIndexEntry>& pages,
+                     const std::set<Name>& updatedPages,
+                     const std::set<Name>& removedPages,
+                     const PageSet* trackedPages,
+                     std::map<Name, DepIndexEntry>* savedPages,
+                     std::pair<long long int, long long int>* savedStamp);
+
+//building in batches (build-all --stream) reads records as they're needed from the build state left mapped in to memory,
+//saving a new build state a batch at a time
+//finds where the latest record of each page and each path is, returns 1 if there isn't a readable build state
+int scan_build_state(MappedIndex& mapped);
+//reads the entry of the page's latest record, returns 0 if it doesn't have one
+bool read_built_entry(const MappedIndex& mapped, const Name& pageName, DepIndexEntry& entry);
+void write_build_state_header(std::ostream& ofs);
+//writes records for a batch of pages, paths get ids from 0 again so those of earlier batches needn't be kept
+void write_built_batch(std::ostream& ofs, const std::map<Name, DepIndexEntry>& pages);
+
+//removes a page from the build state (eg. when untracked), so it is built again if tracked again
+int forget_built_page(const Name& pageName, const PageSet& trackedPages);
+//removes a batch of pages from the build state at once
+int forget_built_pages(const std::set<Name>& pageNames, const PageSet& trackedPages);
+
+#endif //BUILD_STATE_H_
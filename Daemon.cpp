@@ -0,0 +1,446 @@
+#include "Daemon.h"
+
+#if defined _WIN32 || defined _WIN64
+
+int run_daemon()
+{
+    std::cout << "error: the Nift daemon is not available on Windows" << std::endl;
+    return 1;
+}
+
+int stop_daemon()
+{
+    std::cout << "error: the Nift daemon is not available on Windows" << std::endl;
+    return 1;
+}
+
+int daemon_request(int argc, char* argv[], int& ret_val)
+{
+    (void)argc;
+    (void)argv;
+    (void)ret_val;
+
+    return 1;
+}
+
+void notify_daemon()
+{
+}
+
+#else  //unix
+
+const char* socketPath = ".siteinfo/nsm.sock";
+
+std::mutex daemon_os_mtx;
+
+//stream buffer writing to a socket, swapped in for std::cout's buffer while answering a request
+class SocketBuf : public std::streambuf
+{
+    public:
+        SocketBuf(int FD)
+        {
+            fd = FD;
+            setp(buf, buf + sizeof(buf));
+        }
+
+        ~SocketBuf()
+        {
+            sync();
+        }
+
+    protected:
+        int overflow(int c)
+        {
+            if(sync())
+                return traits_type::eof();
+
+            if(c != traits_type::eof())
+            {
+                *pptr() = c;
+                pbump(1);
+            }
+
+            return traits_type::not_eof(c);
+        }
+
+        int sync()
+        {
+            char* pos = pbase();
+            ssize_t n;
+
+            while(pos < pptr())
+            {
+                n = write(fd, pos, pptr() - pos);
+                if(n <= 0) //client has gone away, output is dropped
+                {
+                    setp(buf, buf + sizeof(buf));
+                    return -1;
+                }
+                pos += n;
+            }
+            setp(buf, buf + sizeof(buf));
+
+            return 0;
+        }
+
+    private:
+        int fd;
+        char buf[4096];
+};
+
+bool write_all(int fd, const std::string& str)
+{
+    size_t pos = 0;
+    ssize_t n;
+
+    while(pos < str.size())
+    {
+        n = write(fd, str.c_str() + pos, str.size() - pos);
+        if(n <= 0)
+            return 0;
+        pos += n;
+    }
+
+    return 1;
+}
+
+//connects to the daemon for the site in the current directory, returns -1 if there isn't one running
+int connect_daemon()
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0)
+        return -1;
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath, sizeof(addr.sun_path) - 1);
+
+    if(connect(fd, (sockaddr*)&addr, sizeof(addr)))
+    {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/*
+    requests are the command's arguments each terminated by '\0', ended by the
+    client shutting down its side of the connection. responses are the command's
+    output followed by '\0' and the command's return value
+*/
+bool send_request(int fd, const std::vector<std::string>& args)
+{
+    std::string request;
+    for(size_t a=0; a<args.size(); a++)
+    {
+        request += args[a];
+        request += '\0';
+    }
+
+    if(!write_all(fd, request))
+        return 0;
+
+    shutdown(fd, SHUT_WR);
+
+    return 1;
+}
+
+bool read_request(int fd, std::vector<std::string>& args)
+{
+    std::string request;
+    char buf[4096];
+    ssize_t n;
+
+    while((n = read(fd, buf, sizeof(buf))) > 0)
+        request.append(buf, n);
+    if(n < 0)
+        return 0;
+
+    args.clear();
+    size_t pos = 0, end;
+    while((end = request.find('\0', pos)) != std::string::npos)
+    {
+        args.push_back(request.substr(pos, end - pos));
+        pos = end + 1;
+    }
+
+    return args.size() > 0;
+}
+
+//passes the daemon's output through to std::cout, returns 0 once the return value has been read
+int read_response(int fd, int& ret_val)
+{
+    std::string retStr;
+    bool inOutput = 1;
+    char buf[4096];
+    ssize_t n;
+
+    while((n = read(fd, buf, sizeof(buf))) > 0)
+    {
+        if(inOutput)
+        {
+            char* end = (char*)memchr(buf, '\0', n);
+            if(end)
+            {
+                std::cout.write(buf, end - buf);
+                retStr.append(end + 1, buf + n - end - 1);
+                inOutput = 0;
+            }
+            else
+                std::cout.write(buf, n);
+        }
+        else
+            retStr.append(buf, n);
+    }
+    std::cout.flush();
+
+    //a return value which isn't a number (eg. cut short, or from a different version) counts as a lost connection
+    char* retEnd = NULL;
+    long int retLong = inOutput ? 0 : std::strtol(retStr.c_str(), &retEnd, 10);
+    if(inOutput || retStr == "" || *retEnd != '\0')
+    {
+        std::cout << "error: Daemon.cpp: read_response(): lost connection to the Nift daemon" << std::endl;
+        ret_val = 1;
+        return 1;
+    }
+
+    ret_val = (int)retLong;
+
+    return 0;
+}
+
+int handle_request(SiteInfo& site, const std::vector<std::string>& args)
+{
+    const std::string& cmd = args[0];
+    std::vector<Name> pageNames(args.begin() + 1, args.end());
+    int result;
+
+    if(cmd == "build-updated")
+    {
+        if(run_script(std::cout, "pre-build" + site.scriptExt, &daemon_os_mtx))
+            return 1;
+        if(run_script(std::cout, "pre-build-updated" + site.scriptExt, &daemon_os_mtx))
+            return 1;
+
+        result = site.build_updated(std::cout);
+
+        if(run_script(std::cout, "post-build" + site.scriptExt, &daemon_os_mtx))
+            return 1;
+        if(run_script(std::cout, "post-build-updated" + site.scriptExt, &daemon_os_mtx))
+            return 1;
+
+        return result;
+    }
+    else if(cmd == "build")
+    {
+        if(run_script(std::cout, "pre-build" + site.scriptExt, &daemon_os_mtx))
+            return 1;
+
+        result = site.build(pageNames);
+
+        if(run_script(std::cout, "post-build" + site.scriptExt, &daemon_os_mtx))
+            return 1;
+
+        return result;
+    }
+    else if(cmd == "status")
+        return site.status();
+    else if(cmd == "info")
+        return site.info(pageNames);
+
+    std::cout << "error: the Nift daemon does not handle the command '" << cmd << "'" << std::endl;
+
+    return 1;
+}
+
+void stop_on_signal(int sig)
+{
+    (void)sig;
+
+    unlink(socketPath);
+    _exit(0);
+}
+
+int run_daemon()
+{
+    int listenFD = connect_daemon();
+    if(listenFD >= 0)
+    {
+        close(listenFD);
+        std::cout << "error: a Nift daemon is already running for this site" << std::endl;
+        return 1;
+    }
+
+    //removes socket left behind by a daemon that didn't exit cleanly
+    unlink(socketPath);
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, socketPath, sizeof(addr.sun_path) - 1);
+
+    listenFD = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(listenFD < 0 || bind(listenFD, (sockaddr*)&addr, sizeof(addr)) || listen(listenFD, 16))
+    {
+        std::cout << "error: Daemon.cpp: run_daemon(): failed to listen on " << quote(socketPath) << " in " << quote(get_pwd()) << std::endl;
+        if(listenFD >= 0)
+            close(listenFD);
+        return 1;
+    }
+
+    signal(SIGINT, stop_on_signal);
+    signal(SIGTERM, stop_on_signal);
+    signal(SIGPIPE, SIG_IGN);
+
+    //nsm run from scripts while answering a request would otherwise wait on the daemon
+    setenv("NSM_NO_DAEMON", "1", 1);
+
+    //templates and other files read while building are kept between requests, reread when their stamps change
+    statCache.cacheContents = 1;
+
+    SiteInfo site;
+    bool siteOpen = 0,
+         running = 1;
+    //files the open site is read from, the site is reopened when any of them change
+    const char* siteFiles[] = {".siteinfo/nsm.config", ".siteinfo/pages.list", ".siteinfo/pages.journal", ".siteinfo/pages.index"};
+    const size_t noSiteFiles = sizeof(siteFiles)/sizeof(siteFiles[0]);
+    std::pair<long long int, long long int> siteStamps[noSiteFiles], cStamp;
+    bool siteChanged;
+    std::vector<std::string> args;
+    std::streambuf* coutBuf = std::cout.rdbuf();
+    int clientFD, result;
+
+    std::cout << "Nift daemon answering requests on " << socketPath << " - 'nsm daemon stop' or 'ctrl c' to stop" << std::endl;
+
+    while(running)
+    {
+        clientFD = accept(listenFD, NULL, NULL);
+        if(clientFD < 0)
+            continue;
+
+        if(!read_request(clientFD, args))
+        {
+            close(clientFD);
+            continue;
+        }
+
+        //site is reopened before the next request
+        if(args[0] == "reload")
+        {
+            siteOpen = 0;
+            close(clientFD);
+            continue;
+        }
+
+        {
+            SocketBuf socketBuf(clientFD);
+            std::cout.rdbuf(&socketBuf);
+
+            if(args[0] == "daemon")
+            {
+                std::cout << "Nift daemon stopped" << std::endl;
+                running = 0;
+                result = 0;
+            }
+            else
+            {
+                //only reopens the site when it may have changed
+                siteChanged = !siteOpen;
+                for(size_t f=0; f<noSiteFiles; f++)
+                {
+                    cStamp = file_stamp(siteFiles[f]);
+                    if(cStamp != siteStamps[f])
+                    {
+                        siteStamps[f] = cStamp;
+                        siteChanged = 1;
+                    }
+                }
+                if(siteChanged)
+                    siteOpen = !site.open();
+
+                //the dependency index is reread if it was saved by another nsm (eg. run with NSM_NO_DAEMON set)
+                if(site.depIndex.loaded && file_stamp(site.depIndex.buildState ? ".siteinfo/build.state" : ".siteinfo/deps.index") != site.depIndex.loadedStamp)
+                    site.depIndex.loaded = 0;
+
+                if(siteOpen)
+                    result = handle_request(site, args);
+                else
+                    result = 1;
+            }
+
+            std::cout.flush();
+            std::cout.rdbuf(coutBuf);
+            std::cout.clear();
+        }
+
+        write_all(clientFD, std::string(1, '\0') + std::to_string(result));
+        close(clientFD);
+    }
+
+    close(listenFD);
+    unlink(socketPath);
+
+    return 0;
+}
+
+int stop_daemon()
+{
+    int fd = connect_daemon(),
+        ret_val;
+    if(fd < 0)
+    {
+        std::cout << "error: no Nift daemon is running for this site" << std::endl;
+        return 1;
+    }
+
+    std::vector<std::string> args;
+    args.push_back("daemon");
+    args.push_back("stop");
+    if(!send_request(fd, args))
+    {
+        close(fd);
+        std::cout << "error: Daemon.cpp: stop_daemon(): failed to send request to the Nift daemon" << std::endl;
+        return 1;
+    }
+
+    read_response(fd, ret_val);
+    close(fd);
+
+    return ret_val;
+}
+
+int daemon_request(int argc, char* argv[], int& ret_val)
+{
+    if(getenv("NSM_NO_DAEMON"))
+        return 1;
+
+    int fd = connect_daemon();
+    if(fd < 0)
+        return 1;
+
+    std::vector<std::string> args(argv + 1, argv + argc);
+    if(!send_request(fd, args))
+    {
+        close(fd);
+        return 1;
+    }
+
+    read_response(fd, ret_val);
+    close(fd);
+
+    return 0;
+}
+
+void notify_daemon()
+{
+    int fd = connect_daemon();
+    if(fd < 0)
+        return;
+
+    send_request(fd, std::vector<std::string>(1, "reload"));
+    close(fd);
+}
+
+#endif
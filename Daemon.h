@@ -0,0 +1,30 @@
+#ifndef DAEMON_H_
+#define DAEMON_H_
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+
+#if !defined _WIN32 && !defined _WIN64
+    #include <sys/socket.h>
+    #include <sys/un.h>
+#endif
+
+#include "SiteInfo.h"
+
+//runs a daemon for the site in the current directory which keeps the site open
+//and answers build, build-updated, status and info requests over .siteinfo/nsm.sock
+int run_daemon();
+
+//asks the daemon running for the site in the current directory to stop
+int stop_daemon();
+
+//forwards a command to the daemon running for the site in the current directory (if there is one),
+//returns 0 if the daemon handled the command, with the command's return value put in ret_val
+int daemon_request(int argc, char* argv[], int& ret_val);
+
+//lets a running daemon know the site may have changed
+void notify_daemon();
+
+#endif //DAEMON_H_
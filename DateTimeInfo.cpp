@@ -1,20 +1,53 @@
 #include "DateTimeInfo.h"
 
+//localtime and gmtime share one static tm, pages may be built on several threads
+static void local_time(const time_t& t, struct tm& tstruct)
+{
+    #if defined _WIN32 || defined _WIN64
+        localtime_s(&tstruct, &t);
+    #else  //unix/linux/macOS
+        localtime_r(&t, &tstruct);
+    #endif
+}
+
+static void utc_time(const time_t& t, struct tm& tstruct)
+{
+    #if defined _WIN32 || defined _WIN64
+        gmtime_s(&tstruct, &t);
+    #else  //unix/linux/macOS
+        gmtime_r(&t, &tstruct);
+    #endif
+}
+
 DateTimeInfo::DateTimeInfo()
 {
+    set(time(0));
+}
+
+DateTimeInfo::DateTimeInfo(const time_t& BuildTime)
+{
+    set(BuildTime);
+}
+
+void DateTimeInfo::set(const time_t& BuildTime)
+{
+    buildTime = BuildTime;
     cDate = currentDate();
     cTime = currentTime();
     cTimezone = currentTimezone();
+    cUTCDate = currentUTCDate();
+    cUTCTime = currentUTCTime();
+    cYYYY = currentYYYY();
+    cYY = currentYY();
 }
 
 //returns current date
 std::string DateTimeInfo::currentDate()
 {
-    time_t now = time(0);
     struct tm tstruct;
     char buf[80];
 
-    tstruct = *localtime(&now);
+    local_time(buildTime, tstruct);
     //weekday month day year
     strftime(buf, sizeof(buf), "%A %B %d %Y", &tstruct);
 
@@ -24,11 +57,10 @@ std::string DateTimeInfo::currentDate()
 //returns current UTC date
 std::string DateTimeInfo::currentUTCDate()
 {
-    time_t now = time(0);
     struct tm tstruct;
     char buf[80];
 
-    tstruct = *gmtime(&now);
+    utc_time(buildTime, tstruct);
     //weekday month day year
     strftime(buf, sizeof(buf), "%A %B %d %Y", &tstruct);
 
@@ -38,11 +70,10 @@ std::string DateTimeInfo::currentUTCDate()
 //returns current date
 std::string DateTimeInfo::currentYYYY()
 {
-    time_t now = time(0);
     struct tm tstruct;
     char buf[80];
 
-    tstruct = *localtime(&now);
+    local_time(buildTime, tstruct);
     //weekday month day year
     strftime(buf, sizeof(buf), "%Y", &tstruct);
 
@@ -58,11 +89,10 @@ std::string DateTimeInfo::currentYY()
 //returns current time
 std::string DateTimeInfo::currentTime()
 {
-    time_t now = time(0);
     struct tm tstruct;
     char buf[80];
 
-    tstruct = *localtime(&now);
+    local_time(buildTime, tstruct);
     strftime(buf, sizeof(buf), "%X", &tstruct);
 
     return buf;
@@ -71,10 +101,9 @@ std::string DateTimeInfo::currentTime()
 //returns current UTC time
 std::string DateTimeInfo::currentUTCTime()
 {
-    time_t now = time(0);
     struct tm tstruct;
 
-    tstruct = *gmtime(&now);
+    utc_time(buildTime, tstruct);
     std::stringstream ss;
     if(tstruct.tm_hour < 10)
         ss << "0";
@@ -92,11 +121,10 @@ std::string DateTimeInfo::currentUTCTime()
 //returns current time zone
 std::string DateTimeInfo::currentTimezone()
 {
-    time_t now = time(0);
     struct tm tstruct;
     char buf[80];
 
-    tstruct = *localtime(&now);
+    local_time(buildTime, tstruct);
     strftime(buf, sizeof(buf), "%Z", &tstruct);
 
     return buf;
@@ -16,11 +16,20 @@
 
 struct DateTimeInfo
 {
+    time_t buildTime; //what the current date and time are taken from, pinned for reproducible builds
     std::string cDate,
         cTime,
-        cTimezone;
+        cTimezone,
+        cUTCDate,
+        cUTCTime,
+        cYYYY,
+        cYY;
 
     DateTimeInfo();
+    DateTimeInfo(const time_t& BuildTime);
+
+    //sets buildTime and works out the date and time strings from it once
+    void set(const time_t& BuildTime);
 
 	//returns current date
 	std::string currentDate();
@@ -0,0 +1,691 @@
+#include "DepIndex.h"
+#include "BuildState.h"
+
+/*
+    .siteinfo/deps.index format:
+
+    nsm-deps-index 8
+    pages no-pages
+    page-name info-size info-mtime output-hash page-size page-mtime
+    page-title
+    template-path
+    no-deps dep-id-1 dep-size-1 dep-mtime-1 dep-hash-1 dep-parent-1 .. dep-id-k dep-size-k dep-mtime-k dep-hash-k dep-parent-k
+    no-refs ref-name-1 ref-path-1 .. ref-name-k ref-path-k
+    no-keys key-1 value-1 .. key-k value-k
+    ..
+    deps no-deps
+    dep-path
+    ..
+    pages no-pages
+    ..
+
+    pages are in blocks, each followed by the deps of its pages, dep ids
+    are their positions in the block's deps, dep sizes, mtimes
+    and hashes are as they were when the page was built, dep parents are
+    the positions in the page's deps of the files they were read from
+    (-1 if none), output-hash
+    and the page stamp are from when the page file was last written,
+    refs are the pages linked to with @pathto/@pathtopage and their page
+    paths when the page was built, keys are the config keys read (eg.
+    with @sitedir) and their values when the page was built. the index
+    is a single block in order of page name unless saved a batch at a
+    time, which saves a block for each batch. version 7 indexes (a single
+    block) and version 6 indexes (with the ids of each dependency's pages
+    after its path) are still read
+*/
+
+//reads a number, moving pos past it
+template <class T>
+bool read_number(const char *&pos, const char *end, T& number)
+{
+    while(pos < end && std::isspace((unsigned char)*pos))
+        pos++;
+
+    bool negative = (pos < end && *pos == '-');
+    if(negative)
+        pos++;
+    if(pos == end || !std::isdigit((unsigned char)*pos))
+        return 0;
+
+    unsigned long long int value = 0;
+    for(; pos < end && std::isdigit((unsigned char)*pos); pos++)
+        value = 10*value + (*pos - '0');
+    number = negative ? (T)(-(long long int)value) : (T)value;
+
+    return 1;
+}
+
+bool read_path(const char *&pos, const char *end, std::string& buf, Path& path)
+{
+    if(!read_quoted(pos, end, buf))
+        return 0;
+    path.set_file_path_from(buf);
+
+    return 1;
+}
+
+bool read_header(const char *&pos, const char *end, int& version)
+{
+    std::string header;
+
+    return read_quoted(pos, end, header) && header == "nsm-deps-index" &&
+           read_number(pos, end, version) && version >= 6 && version <= 8;
+}
+
+//reads the start of a block of pages
+bool read_block(const char *&pos, const char *end, size_t& noPages)
+{
+    std::string section;
+
+    return read_quoted(pos, end, section) && section == "pages" && read_number(pos, end, noPages);
+}
+
+//reads a page's entry (following its name) with the ids of its deps rather than their paths
+bool read_entry(const char *&pos, const char *end, std::string& buf, DepIndexEntry& entry, std::vector<size_t>& depIDs)
+{
+    size_t noIDs;
+
+    if(!read_number(pos, end, entry.infoStamp.first) || !read_number(pos, end, entry.infoStamp.second) ||
+       !read_number(pos, end, entry.outputHash) || !read_number(pos, end, entry.pageStamp.first) || !read_number(pos, end, entry.pageStamp.second) ||
+       !read_quoted(pos, end, entry.pageTitle.str) ||
+       !read_path(pos, end, buf, entry.templatePath) ||
+       !read_number(pos, end, noIDs))
+        return 0;
+
+    depIDs.resize(noIDs);
+    entry.depStamps.resize(noIDs);
+    entry.depParents.resize(noIDs);
+    for(size_t d=0; d<noIDs; d++)
+        if(!read_number(pos, end, depIDs[d]) ||
+           !read_number(pos, end, entry.depStamps[d].stamp.first) || !read_number(pos, end, entry.depStamps[d].stamp.second) ||
+           !read_number(pos, end, entry.depStamps[d].hash) || !read_number(pos, end, entry.depParents[d]))
+            return 0;
+
+    if(!read_number(pos, end, noIDs))
+        return 0;
+    entry.pageRefs.resize(noIDs);
+    for(size_t r=0; r<noIDs; r++)
+        if(!read_quoted(pos, end, entry.pageRefs[r].first) || !read_path(pos, end, buf, entry.pageRefs[r].second))
+            return 0;
+
+    if(!read_number(pos, end, noIDs))
+        return 0;
+    entry.configDeps.resize(noIDs);
+    for(size_t k=0; k<noIDs; k++)
+        if(!read_quoted(pos, end, entry.configDeps[k].first) || !read_quoted(pos, end, entry.configDeps[k].second))
+            return 0;
+
+    return 1;
+}
+
+//reads the deps of a block, or when pathOffsets is set just finds where each is in the index starting at data
+bool read_dep_paths(const char *data, const char *&pos, const char *end, const int& version, std::vector<Path>& depPaths, std::vector<size_t>* pathOffsets)
+{
+    std::string section, buf;
+    size_t noDeps;
+
+    if(!read_quoted(pos, end, section) || section != "deps" || !read_number(pos, end, noDeps))
+        return 0;
+
+    depPaths.resize(pathOffsets ? 1 : noDeps);
+    for(size_t d=0; d<noDeps; d++)
+    {
+        if(pathOffsets)
+        {
+            while(pos < end && std::isspace((unsigned char)*pos))
+                pos++;
+            pathOffsets->push_back(pos - data);
+        }
+        if(!read_path(pos, end, buf, depPaths[pathOffsets ? 0 : d]))
+            return 0;
+
+        //skips the pages of the dependency, they're worked out from the pages' deps
+        if(version == 6)
+        {
+            pos = (const char*)std::memchr(pos, '\n', end - pos);
+            if(!pos || !(pos = (const char*)std::memchr(pos+1, '\n', end - pos - 1)))
+                return 0;
+        }
+    }
+
+    return 1;
+}
+
+bool set_deps(DepIndexEntry& entry, const std::vector<size_t>& depIDs, const std::vector<Path>& depPaths)
+{
+    entry.deps.resize(depIDs.size());
+    for(size_t d=0; d<depIDs.size(); d++)
+    {
+        if(depIDs[d] >= depPaths.size())
+            return 0;
+        entry.deps[d] = depPaths[depIDs[d]];
+    }
+
+    return 1;
+}
+
+//skips whitespace, returns whether the end of the index has been reached
+bool at_end(const char *&pos, const char *end)
+{
+    while(pos < end && std::isspace((unsigned char)*pos))
+        pos++;
+
+    return pos == end;
+}
+
+//reads the index, entries are read straight in to pages and the pages of each dependency are worked out from them
+bool read_index(const char *pos, const char *end, std::map<Name, DepIndexEntry>& pages, std::map<Path, std::vector<DepSlot> >* reverse)
+{
+    const char *data = pos;
+    std::string buf;
+    int version;
+    size_t noPages;
+
+    if(!read_header(pos, end, version))
+        return 0;
+
+    Name pageName;
+    std::vector<std::map<Name, DepIndexEntry>::iterator> pageIts;
+    std::vector<std::vector<size_t> > depIDs;
+    std::vector<Path> depPaths;
+    std::vector<std::vector<DepSlot> > depSlots;
+    while(!at_end(pos, end))
+    {
+        if(!read_block(pos, end, noPages))
+            return 0;
+
+        pageIts.resize(noPages);
+        depIDs.resize(noPages);
+        for(size_t p=0; p<noPages; p++)
+        {
+            if(!read_quoted(pos, end, pageName))
+                return 0;
+            pageIts[p] = pages.insert(pages.end(), std::make_pair(pageName, DepIndexEntry()));
+            if(!read_entry(pos, end, buf, pageIts[p]->second, depIDs[p]))
+                return 0;
+        }
+
+        if(!read_dep_paths(data, pos, end, version, depPaths, NULL))
+            return 0;
+
+        depSlots.assign(reverse ? depPaths.size() : 0, std::vector<DepSlot>());
+        for(size_t p=0; p<noPages; p++)
+        {
+            if(!set_deps(pageIts[p]->second, depIDs[p], depPaths))
+                return 0;
+            if(reverse)
+                for(size_t d=0; d<depIDs[p].size(); d++)
+                    depSlots[depIDs[p][d]].push_back(DepSlot(pageIts[p], d));
+        }
+
+        //deps of pages in more than one block have the pages of each block added
+        if(reverse)
+        {
+            for(size_t d=0; d<depPaths.size(); d++)
+            {
+                if(!depSlots[d].size())
+                    continue;
+                std::vector<DepSlot>& slots = (*reverse)[depPaths[d]];
+                if(slots.size())
+                    slots.insert(slots.end(), depSlots[d].begin(), depSlots[d].end());
+                else
+                    slots.swap(depSlots[d]);
+            }
+        }
+    }
+
+    return 1;
+}
+
+Name entry_name(const char *pos, const char *end)
+{
+    Name pageName;
+    read_quoted(pos, end, pageName);
+
+    return pageName;
+}
+
+//finds where each page's entry and each dependency path is in the mapped index rather than reading them in
+bool scan_index(MappedIndex& mapped)
+{
+    const char *data = mapped.file.data,
+               *pos = data,
+               *end = data + mapped.file.size;
+    std::string buf;
+    size_t noPages;
+
+    if(!pos || !read_header(pos, end, mapped.version))
+        return 0;
+
+    Name pageName, prevName;
+    bool sorted = 1;
+    DepIndexEntry entry;
+    std::vector<size_t> depIDs;
+    std::vector<Path> depPaths;
+    while(!at_end(pos, end))
+    {
+        if(!read_block(pos, end, noPages))
+            return 0;
+        mapped.pathBlocks.push_back(std::make_pair((size_t)(pos - data), mapped.pathOffsets.size()));
+
+        for(size_t p=0; p<noPages; p++)
+        {
+            mapped.offsets.push_back(pos - data);
+            if(!read_quoted(pos, end, pageName) || !read_entry(pos, end, buf, entry, depIDs))
+                return 0;
+            sorted = sorted && !(pageName < prevName);
+            prevName.swap(pageName);
+        }
+
+        if(!read_dep_paths(data, pos, end, mapped.version, depPaths, &mapped.pathOffsets))
+            return 0;
+    }
+
+    //an index saved a batch at a time is in order of page name within each batch
+    if(!sorted)
+        std::sort(mapped.offsets.begin(), mapped.offsets.end(),
+            [data, end](const size_t& a, const size_t& b) { return entry_name(data + a, end) < entry_name(data + b, end); });
+
+    return 1;
+}
+
+void write_entry(std::ostream& ofs, const Name& pageName, const DepIndexEntry& entry, std::unordered_map<Path, unsigned int>& depIDs)
+{
+    ofs << quote(pageName) << " " << entry.infoStamp.first << " " << entry.infoStamp.second;
+    ofs << " " << entry.outputHash << " " << entry.pageStamp.first << " " << entry.pageStamp.second << "\n";
+    ofs << entry.pageTitle << "\n";
+    ofs << entry.templatePath << "\n";
+    ofs << entry.deps.size();
+    for(size_t d=0; d<entry.deps.size(); d++)
+    {
+        //deps get ids in the order they first appear
+        auto depID = depIDs.insert(std::make_pair(entry.deps[d], (unsigned int)depIDs.size())).first;
+        const DepStamp& depStamp = entry.depStamps[d];
+        ofs << " " << depID->second << " " << depStamp.stamp.first << " " << depStamp.stamp.second << " " << depStamp.hash;
+        ofs << " " << (d < entry.depParents.size() ? entry.depParents[d] : -1);
+    }
+    ofs << "\n";
+    ofs << entry.pageRefs.size();
+    for(size_t r=0; r<entry.pageRefs.size(); r++)
+        ofs << " " << quote(entry.pageRefs[r].first) << " " << entry.pageRefs[r].second;
+    ofs << "\n";
+    ofs << entry.configDeps.size();
+    for(size_t k=0; k<entry.configDeps.size(); k++)
+        ofs << " " << quote(entry.configDeps[k].first) << " " << quote(entry.configDeps[k].second);
+    ofs << "\n";
+}
+
+void write_dep_paths(std::ostream& ofs, const std::unordered_map<Path, unsigned int>& depIDs)
+{
+    std::vector<Path> depPaths(depIDs.size());
+    for(auto depID=depIDs.begin(); depID!=depIDs.end(); depID++)
+        depPaths[depID->second] = depID->first;
+
+    ofs << "deps " << depPaths.size() << "\n";
+    for(size_t d=0; d<depPaths.size(); d++)
+        ofs << depPaths[d] << "\n";
+}
+
+DepIndexEntry::DepIndexEntry()
+{
+    outputHash = 0;
+    pageStamp = std::make_pair(-1LL, -1LL);
+}
+
+DepIndex::DepIndex()
+{
+    hashDeps = 0;
+    buildState = 0;
+    reverseIndex = 1;
+    loaded = 0;
+    loadedBuildState = 0;
+    reverseLoaded = 0;
+    batched = 0;
+    mapped.version = 0;
+    mapped.lockFD = -1;
+}
+
+int DepIndex::open()
+{
+    //building in batches only finds where entries are, the index is locked so it can be saved a batch at a time
+    if(batched)
+    {
+        pages.clear();
+        reverse.clear();
+        updatedPages.clear();
+        mapped.offsets.clear();
+        mapped.pathOffsets.clear();
+        mapped.pathBlocks.clear();
+
+        //the old index (build state) is only read, the new one is saved a batch at a time and replaces it once saved
+        if(buildState)
+        {
+            mapped.lockFD = lock_file(".siteinfo/build.state.lock");
+            if(mapped.file.open(".siteinfo/build.state") || scan_build_state(mapped))
+                mapped.file.close();
+            mapped.savedOfs.open(".siteinfo/build.state.tmp", std::ios::binary);
+            write_build_state_header(mapped.savedOfs);
+        }
+        else
+        {
+            mapped.lockFD = lock_file(".siteinfo/deps.index.lock");
+            if(mapped.file.open(".siteinfo/deps.index") || !scan_index(mapped))
+                mapped.file.close();
+            mapped.savedOfs.open(".siteinfo/deps.index.tmp");
+            mapped.savedOfs << "nsm-deps-index 8\n";
+        }
+        if(!mapped.file.data)
+        {
+            mapped.offsets.clear();
+            mapped.pathOffsets.clear();
+            mapped.pathBlocks.clear();
+        }
+
+        return 0;
+    }
+
+    //rereads the index unless it is unchanged since it was last read or saved, throwing away unsaved updates
+    std::pair<long long int, long long int> stamp = file_stamp(buildState ? ".siteinfo/build.state" : ".siteinfo/deps.index");
+    if(loaded && loadedBuildState == buildState && loadedStamp == stamp && !updatedPages.size())
+    {
+        if(reverseIndex && !reverseLoaded)
+            open_reverse();
+        return 0;
+    }
+
+    pages.clear();
+    reverse.clear();
+    updatedPages.clear();
+    loaded = 1;
+    loadedBuildState = buildState;
+    loadedStamp = stamp;
+    reverseLoaded = 0;
+
+    if(buildState)
+    {
+        read_build_state(pages);
+        if(reverseIndex)
+            open_reverse();
+        return 0;
+    }
+
+    std::string contents;
+    if(read_file(".siteinfo/deps.index", contents))
+        return 0;
+
+    //an unreadable index is just ignored, pages fall back to their info files
+    if(!read_index(contents.c_str(), contents.c_str() + contents.size(), pages, reverseIndex ? &reverse : NULL))
+    {
+        pages.clear();
+        reverse.clear();
+    }
+    reverseLoaded = reverseIndex;
+
+    return 0;
+}
+
+//works out the pages of each dependency from the pages' deps
+void DepIndex::open_reverse()
+{
+    reverse.clear();
+    for(auto page=pages.begin(); page!=pages.end(); page++)
+        for(size_t d=0; d<page->second.deps.size(); d++)
+            reverse[page->second.deps[d]].push_back(DepSlot(page, d));
+    reverseLoaded = 1;
+}
+
+const DepIndexEntry* DepIndex::find(const Name& pageName, const std::pair<long long int, long long int>& infoStamp) const
+{
+    auto entry = pages.find(pageName);
+
+    if(entry == pages.end() || entry->second.infoStamp != infoStamp)
+        return NULL;
+
+    return &entry->second;
+}
+
+const DepIndexEntry* DepIndex::find(const Name& pageName) const
+{
+    auto entry = pages.find(pageName);
+
+    if(entry == pages.end())
+        return NULL;
+
+    return &entry->second;
+}
+
+void DepIndex::update(const Name& pageName, const DepIndexEntry& entry)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    pages[pageName] = entry;
+    updatedPages.insert(pageName);
+}
+
+bool DepIndex::read_mapped(const Name& pageName, DepIndexEntry& entry) const
+{
+    if(buildState)
+        return read_built_entry(mapped, pageName, entry);
+
+    const char *data = mapped.file.data,
+               *end = data + mapped.file.size;
+    auto offset = std::lower_bound(mapped.offsets.begin(), mapped.offsets.end(), pageName,
+        [data, end](const size_t& a, const Name& name) { return entry_name(data + a, end) < name; });
+    if(offset == mapped.offsets.end())
+        return 0;
+
+    const char *pos = data + *offset;
+    std::string buf;
+    Name name;
+    std::vector<size_t> depIDs;
+    if(!read_quoted(pos, end, name) || name != pageName || !read_entry(pos, end, buf, entry, depIDs))
+        return 0;
+
+    //dep ids are positions in the deps of the entry's block
+    auto block = std::upper_bound(mapped.pathBlocks.begin(), mapped.pathBlocks.end(), std::make_pair(*offset, std::string::npos)) - 1;
+    size_t noPaths = (block+1 == mapped.pathBlocks.end() ? mapped.pathOffsets.size() : (block+1)->second) - block->second;
+    entry.deps.resize(depIDs.size());
+    for(size_t d=0; d<depIDs.size(); d++)
+    {
+        if(depIDs[d] >= noPaths)
+            return 0;
+        pos = data + mapped.pathOffsets[block->second + depIDs[d]];
+        if(!read_path(pos, end, buf, entry.deps[d]))
+            return 0;
+    }
+
+    return 1;
+}
+
+bool DepIndex::last_output(const Name& pageName, unsigned long long int& outputHash, std::pair<long long int, long long int>& pageStamp)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    DepIndexEntry mappedEntry;
+    const DepIndexEntry* entry = find(pageName);
+    if(!entry && batched && read_mapped(pageName, mappedEntry))
+        entry = &mappedEntry;
+    if(!entry || !entry->outputHash)
+        return 0;
+
+    outputHash = entry->outputHash;
+    pageStamp = entry->pageStamp;
+
+    return 1;
+}
+
+bool DepIndex::last_deps(const Name& pageName, std::vector<Path>& deps)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    DepIndexEntry mappedEntry;
+    const DepIndexEntry* entry = find(pageName);
+    if(!entry && batched && read_mapped(pageName, mappedEntry))
+        entry = &mappedEntry;
+    if(!entry)
+        return 0;
+
+    deps = entry->deps;
+
+    return 1;
+}
+
+void DepIndex::stamp_deps(DepIndexEntry& entry, const bool& cached) const
+{
+    entry.depStamps.resize(entry.deps.size());
+    for(size_t d=0; d<entry.deps.size(); d++)
+    {
+        DepStamp& depStamp = entry.depStamps[d];
+        std::string depPathStr = entry.deps[d].str();
+
+        if(cached)
+            depStamp.stamp = statCache.stamp(depPathStr);
+        else
+            depStamp.stamp = file_stamp(depPathStr);
+
+        if(hashDeps && depStamp.stamp.second >= 0)
+            depStamp.hash = statCache.hash(depPathStr, depStamp.stamp);
+        else
+            depStamp.hash = 0;
+    }
+}
+
+bool DepIndex::dep_changed(const DepIndexEntry& entry, const size_t& d, const std::pair<long long int, long long int>& depStamp) const
+{
+    //any change to the size or modification time counts, including older modification times (eg. from restoring files)
+    if(depStamp == entry.depStamps[d].stamp)
+        return 0;
+
+    //files which have been touched (eg. by a git checkout) but have the same contents don't need rebuilding from
+    if(hashDeps && entry.depStamps[d].hash && depStamp.first == entry.depStamps[d].stamp.first)
+        return statCache.hash(entry.deps[d].str(), depStamp) != entry.depStamps[d].hash;
+
+    return 1;
+}
+
+int DepIndex::save_batch(const PageSet& batchPages)
+{
+    //pages of the batch which weren't updated (eg. failed to build) keep their entries, pages no longer tracked aren't in any batch so their entries are dropped
+    for(auto page=batchPages.begin(); page!=batchPages.end(); page++)
+    {
+        DepIndexEntry entry;
+        if(!updatedPages.count(page->pageName) && read_mapped(page->pageName, entry))
+            pages[page->pageName] = entry;
+    }
+
+    if(pages.size())
+    {
+        if(buildState)
+            write_built_batch(mapped.savedOfs, pages);
+        else
+        {
+            //dep ids are just for the batch's block so deps of earlier batches needn't be kept
+            std::unordered_map<Path, unsigned int> depIDs;
+            mapped.savedOfs << "pages " << pages.size() << "\n";
+            for(auto page=pages.begin(); page!=pages.end(); page++)
+                write_entry(mapped.savedOfs, page->first, page->second, depIDs);
+            write_dep_paths(mapped.savedOfs, depIDs);
+        }
+    }
+
+    pages.clear();
+    updatedPages.clear();
+
+    return 0;
+}
+
+//merges updated entries into the index on disk, which may have been updated by other processes (eg. build shards)
+int DepIndex::save(const PageSet* trackedPages)
+{
+    if(batched)
+    {
+        //replaces the index (build state) with the one saved a batch at a time, unless it couldn't be written
+        std::string indexPath = buildState ? ".siteinfo/build.state" : ".siteinfo/deps.index";
+        mapped.savedOfs.close();
+        mapped.file.close();
+        bool saved = mapped.savedOfs.good();
+        if(saved)
+        {
+            #if defined _WIN32 || defined _WIN64
+                std::remove(indexPath.c_str());
+            #endif
+            std::rename((indexPath + ".tmp").c_str(), indexPath.c_str());
+        }
+        else
+            std::remove((indexPath + ".tmp").c_str());
+
+        unlock_file(mapped.lockFD, indexPath + ".lock");
+
+        mapped.offsets.clear();
+        mapped.pathOffsets.clear();
+        mapped.pathBlocks.clear();
+        mapped.lockFD = -1;
+
+        return !saved;
+    }
+
+    if(!updatedPages.size())
+        return 0;
+
+    //pages are left as saved (including entries saved by other processes) so the index needn't be reread
+    std::map<Name, DepIndexEntry> savedPages;
+    reverse.clear();
+    reverseLoaded = 0;
+    loaded = 1;
+    loadedBuildState = buildState;
+
+    if(buildState)
+    {
+        save_build_state(pages, updatedPages, std::set<Name>(), trackedPages, &savedPages, &loadedStamp);
+        pages.swap(savedPages);
+        updatedPages.clear();
+        return 0;
+    }
+
+    int lockFD = lock_file(".siteinfo/deps.index.lock");
+
+    std::string contents;
+    if(!read_file(".siteinfo/deps.index", contents) && !read_index(contents.c_str(), contents.c_str() + contents.size(), savedPages, NULL))
+        savedPages.clear();
+    contents.clear();
+
+    for(auto pageName=updatedPages.begin(); pageName!=updatedPages.end(); pageName++)
+        savedPages[*pageName] = pages[*pageName];
+
+    //drops pages no longer being tracked
+    if(trackedPages)
+    {
+        std::set<Name> trackedNames;
+        for(auto page=trackedPages->begin(); page!=trackedPages->end(); page++)
+            trackedNames.insert(trackedNames.end(), page->pageName);
+        for(auto page=savedPages.begin(); page!=savedPages.end();)
+        {
+            if(trackedNames.count(page->first))
+                page++;
+            else
+                page = savedPages.erase(page);
+        }
+    }
+
+    std::unordered_map<Path, unsigned int> depIDs;
+    std::ofstream ofs(".siteinfo/deps.index.tmp");
+    ofs << "nsm-deps-index 8\n";
+    ofs << "pages " << savedPages.size() << "\n";
+    for(auto page=savedPages.begin(); page!=savedPages.end(); page++)
+        write_entry(ofs, page->first, page->second, depIDs);
+    write_dep_paths(ofs, depIDs);
+    ofs.close();
+
+    #if defined _WIN32 || defined _WIN64
+        std::remove(".siteinfo/deps.index");
+    #endif
+    std::rename(".siteinfo/deps.index.tmp", ".siteinfo/deps.index");
+    loadedStamp = file_stamp(".siteinfo/deps.index");
+
+    unlock_file(lockFD, ".siteinfo/deps.index.lock");
+
+    pages.swap(savedPages);
+    updatedPages.clear();
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+#ifndef DEP_INDEX_H_
+#define DEP_INDEX_H_
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+#include "FileSystem.h"
+#include "PageSet.h"
+#include "StatCache.h"
+
+//stamp of a dependency when a page was built, hash is 0 unless content hashes are recorded
+struct DepStamp
+{
+    std::pair<long long int, long long int> stamp;
+    unsigned long long int hash;
+};
+
+//what a page's info file recorded when the page was last built
+struct DepIndexEntry
+{
+    std::pair<long long int, long long int> infoStamp; //stamp of the info file the entry matches, (0, when built) if the page has no info file
+    Title pageTitle;
+    Path templatePath;
+    std::vector<Path> deps;
+    std::vector<DepStamp> depStamps; //same order as deps
+    std::vector<int> depParents; //same order as deps, position in deps of the file each was first read from, -1 if none
+    std::vector<std::pair<Name, Path> > pageRefs; //pages linked to and their page paths when built
+    std::vector<std::pair<std::string, std::string> > configDeps; //config keys read and their values when built
+    unsigned long long int outputHash; //hash of the page written, 0 if unknown
+    std::pair<long long int, long long int> pageStamp; //stamp of the page file once written
+
+    DepIndexEntry();
+};
+
+//a page with a dependency and the dependency's position in the page's deps
+struct DepSlot
+{
+    std::map<Name, DepIndexEntry>::iterator page;
+    size_t d;
+
+    DepSlot(const std::map<Name, DepIndexEntry>::iterator& Page, const size_t& D) : page(Page), d(D) {}
+};
+
+//what is kept of the index file while building in batches, entries are read from the file mapped in to memory as they're needed
+struct MappedIndex
+{
+    MappedFile file;
+    int version;
+    std::vector<size_t> offsets; //where each page's entry (build state: latest record) is, in order of page name
+    std::vector<size_t> pathOffsets; //where each dependency path (build state: each path record) is
+    std::vector<std::pair<size_t, size_t> > pathBlocks; //where each block of entries (build state: run of records after path ids start again) starts and its first path
+    std::ofstream savedOfs; //the new index (build state) saved a batch at a time
+    int lockFD;
+};
+
+/*
+    index of every page's dependencies (forward) and every dependency's
+    pages (reverse) kept in .siteinfo/deps.index, so build-updated can
+    work out which pages need building without opening each info file.
+    with buildState set the entries are read from and saved to
+    .siteinfo/build.state and pages don't have info files
+*/
+struct DepIndex
+{
+    std::mutex mtx;
+    std::map<Name, DepIndexEntry> pages;
+    std::map<Path, std::vector<DepSlot> > reverse; //only valid until entries are updated
+    std::set<Name> updatedPages;
+    bool hashDeps; //whether content hashes of dependencies are recorded and checked
+    bool buildState; //whether entries are kept in .siteinfo/build.state instead of info files
+    bool reverseIndex; //whether pages of each dependency are worked out when opening, only checking for updated pages needs them
+    bool loaded; //whether pages are as in the index file with loadedStamp, so it isn't reread (eg. by the daemon)
+    bool loadedBuildState;
+    std::pair<long long int, long long int> loadedStamp;
+    bool reverseLoaded;
+    bool batched; //entries are read as needed and saved a batch at a time (build-all --stream), the index stays locked until saved
+    MappedIndex mapped;
+
+    DepIndex();
+
+    int open();
+    void open_reverse();
+    //keeps entries of pages it can't check are still tracked when trackedPages is NULL
+    int save(const PageSet* trackedPages);
+    //saves the entries of the batch's pages, updated or as they were, and drops them (building in batches)
+    int save_batch(const PageSet& batchPages);
+    bool read_mapped(const Name& pageName, DepIndexEntry& entry) const;
+
+    //only valid if the page's info file still has the stamp recorded in the entry
+    const DepIndexEntry* find(const Name& pageName, const std::pair<long long int, long long int>& infoStamp) const;
+    //entries from the build state don't depend on info files
+    const DepIndexEntry* find(const Name& pageName) const;
+    void update(const Name& pageName, const DepIndexEntry& entry);
+    //output hash and page file stamp from when the page was last written, safe to call while build threads update entries
+    bool last_output(const Name& pageName, unsigned long long int& outputHash, std::pair<long long int, long long int>& pageStamp);
+    //dependencies of the page when it was last built, also safe to call while build threads update entries
+    bool last_deps(const Name& pageName, std::vector<Path>& deps);
+
+    //records the stamps (and content hashes) of the entry's dependencies, cached from this build pass or stat'ed afresh
+    void stamp_deps(DepIndexEntry& entry, const bool& cached) const;
+    //whether dependency d of the entry has changed since the page was built, given its current stamp
+    bool dep_changed(const DepIndexEntry& entry, const size_t& d, const std::pair<long long int, long long int>& depStamp) const;
+};
+
+#endif //DEP_INDEX_H_
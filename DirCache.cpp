@@ -0,0 +1,101 @@
+#include "DirCache.h"
+
+DirCache dirCache;
+
+void DirCache::clear()
+{
+    for(int s=0; s<noShards; s++)
+    {
+        std::lock_guard<std::mutex> lock(mtxs[s]);
+        components[s].clear();
+        between[s].clear();
+    }
+}
+
+//splits the directory (without any leading ./) after each '/', a last component without a '/' is kept as empty like dirDeque does
+std::vector<StringID> DirCache::dir_components(const StringID& dirID)
+{
+    size_t s = dirID % noShards;
+
+    {
+        std::lock_guard<std::mutex> lock(mtxs[s]);
+        auto found = components[s].find(dirID);
+        if(found != components[s].end())
+            return found->second;
+    }
+
+    const StringPool::Entry& dirEntry = stringPool.entry(dirID);
+    const char* dirStr = dirEntry.str;
+    size_t dirSize = dirEntry.size;
+    if(dirSize > 1 && dirStr[0] == '.' && dirStr[1] == '/')
+    {
+        dirStr += 2;
+        dirSize -= 2;
+    }
+
+    std::vector<StringID> dirComponents;
+    for(size_t pos=0; pos<dirSize;)
+    {
+        const char* slash = (const char*)std::memchr(dirStr + pos, '/', dirSize - pos);
+        if(!slash)
+        {
+            dirComponents.push_back(0);
+            break;
+        }
+        size_t end = slash - dirStr + 1;
+        dirComponents.push_back(stringPool.intern(dirStr + pos, end - pos));
+        pos = end;
+    }
+
+    std::lock_guard<std::mutex> lock(mtxs[s]);
+    components[s][dirID] = dirComponents;
+
+    return dirComponents;
+}
+
+StringID DirCache::dir_between(const StringID& sourceDirID, const StringID& targetDirID)
+{
+    unsigned long long int key = ((unsigned long long int)sourceDirID << 32) | targetDirID;
+    size_t s = (sourceDirID ^ targetDirID) % noShards;
+
+    {
+        std::lock_guard<std::mutex> lock(mtxs[s]);
+        auto found = between[s].find(key);
+        if(found != between[s].end())
+            return found->second;
+    }
+
+    std::vector<StringID> sourceComponents = dir_components(sourceDirID),
+                          targetComponents = dir_components(targetDirID);
+
+    size_t noCommon = 0;
+    while(noCommon < sourceComponents.size() && noCommon < targetComponents.size() &&
+          sourceComponents[noCommon] == targetComponents[noCommon])
+        noCommon++;
+
+    std::string sourceToTarget;
+    for(size_t c=noCommon; c<sourceComponents.size(); c++)
+        sourceToTarget += "../";
+    for(size_t c=noCommon; c<targetComponents.size(); c++)
+    {
+        const StringPool::Entry& component = stringPool.entry(targetComponents[c]);
+        sourceToTarget.append(component.str, component.size);
+    }
+
+    StringID betweenID = stringPool.intern(sourceToTarget);
+
+    std::lock_guard<std::mutex> lock(mtxs[s]);
+    between[s][key] = betweenID;
+
+    return betweenID;
+}
+
+Path path_between(const Path& sourcePath, const Path& targetPath)
+{
+    Path pathToTarget;
+
+    pathToTarget.dirID = dirCache.dir_between(sourcePath.dirID, targetPath.dirID);
+    pathToTarget.fileID = targetPath.fileID;
+
+    return pathToTarget;
+}
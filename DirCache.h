@@ -0,0 +1,38 @@
+#ifndef DIR_CACHE_H_
+#define DIR_CACHE_H_
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "Path.h"
+
+/*
+    memoizes relative paths between directories (for @pathto, @pathtopage,
+    @pathtofile, @cssinclude etc.). each directory is split in to interned
+    components once (as dirDeque does), the relative directory between two
+    directories is worked out from the length of their common prefix of
+    components and kept for the pair. directories are interned so entries
+    never go out of date. shared between threads, the maps are split in to
+    separately locked shards
+*/
+struct DirCache
+{
+    static const int noShards = 16;
+
+    std::mutex mtxs[noShards];
+    std::unordered_map<StringID, std::vector<StringID> > components[noShards];
+    std::unordered_map<unsigned long long int, StringID> between[noShards];
+
+    void clear();
+
+    std::vector<StringID> dir_components(const StringID& dirID);
+    StringID dir_between(const StringID& sourceDirID, const StringID& targetDirID);
+};
+
+extern DirCache dirCache;
+
+//path to targetPath from a file in sourcePath's directory, same as pathBetween on their directories
+Path path_between(const Path& sourcePath, const Path& targetPath);
+
+#endif //DIR_CACHE_H_
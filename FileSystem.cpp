@@ -146,3 +146,140 @@ int cpFile(const std::string& sourceFile, const std::string& targetFile)
 
 	return 0;
 }
+
+std::pair<long long int, long long int> file_stamp(const std::string& path)
+{
+    struct stat info;
+
+    if(stat(path.c_str(), &info))
+        return std::make_pair(-1LL, -1LL);
+
+    #if defined _WIN32 || defined _WIN64
+        return std::make_pair((long long int)info.st_size, info.st_mtime*1000000000LL);
+    #elif defined __APPLE__
+        return std::make_pair((long long int)info.st_size, info.st_mtimespec.tv_sec*1000000000LL + info.st_mtimespec.tv_nsec);
+    #else  //unix
+        return std::make_pair((long long int)info.st_size, info.st_mtim.tv_sec*1000000000LL + info.st_mtim.tv_nsec);
+    #endif
+}
+
+unsigned long long int file_hash(const std::string& path)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    if(!ifs)
+        return 0;
+
+    unsigned long long int hash = fnv1a("", 0);
+    char buf[65536];
+    while(ifs.read(buf, sizeof(buf)) || ifs.gcount())
+        hash = fnv1a(buf, ifs.gcount(), hash);
+
+    return hash;
+}
+
+int read_file(const std::string& path, std::string& contents)
+{
+    std::ifstream ifs(path, std::ios::binary);
+    if(!ifs)
+        return 1;
+
+    ifs.seekg(0, std::ios::end);
+    contents.resize(ifs.tellg());
+    ifs.seekg(0, std::ios::beg);
+    ifs.read(&contents[0], contents.size());
+    contents.resize(ifs.gcount());
+
+    return 0;
+}
+
+MappedFile::MappedFile()
+{
+    data = NULL;
+    size = 0;
+}
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+int MappedFile::open(const std::string& path)
+{
+    close();
+
+    #if defined _WIN32 || defined _WIN64
+        if(read_file(path, contents) || contents.empty())
+            return 1;
+        data = contents.c_str();
+        size = contents.size();
+    #else  //unix
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0)
+            return 1;
+
+        struct stat info;
+        if(fstat(fd, &info) || info.st_size == 0)
+        {
+            ::close(fd);
+            return 1;
+        }
+
+        void* mapped = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if(mapped == MAP_FAILED)
+            return 1;
+        data = (const char*)mapped;
+        size = info.st_size;
+    #endif
+
+    return 0;
+}
+
+void MappedFile::close()
+{
+    #if defined _WIN32 || defined _WIN64
+        contents.clear();
+    #else  //unix
+        if(data)
+            munmap((void*)data, size);
+    #endif
+    data = NULL;
+    size = 0;
+}
+
+int lock_file(const std::string& lockPath)
+{
+    #if defined _WIN32 || defined _WIN64
+        return -1;
+    #else  //unix
+        struct stat fdInfo, pathInfo;
+
+        while(1)
+        {
+            int lockFD = ::open(lockPath.c_str(), O_RDWR | O_CREAT, 0644);
+            if(lockFD < 0)
+                return -1;
+            if(flock(lockFD, LOCK_EX) || fstat(lockFD, &fdInfo))
+            {
+                close(lockFD);
+                return -1;
+            }
+
+            //whoever held the lock removes the lock file before releasing it, tries again if it went while waiting
+            if(!stat(lockPath.c_str(), &pathInfo) && pathInfo.st_dev == fdInfo.st_dev && pathInfo.st_ino == fdInfo.st_ino)
+                return lockFD;
+            close(lockFD);
+        }
+    #endif
+}
+
+void unlock_file(int lockFD, const std::string& lockPath)
+{
+    #if !defined _WIN32 && !defined _WIN64
+        if(lockFD < 0)
+            return;
+        unlink(lockPath.c_str());
+        flock(lockFD, LOCK_UN);
+        close(lockFD);
+    #endif
+}
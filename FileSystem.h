@@ -2,11 +2,20 @@
 #define FILE_SYSTEM_H_
 
 #include <dirent.h>
+#include <fstream>
 #include <unistd.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <utility>
 #include <vector>
 
+#if !defined _WIN32 && !defined _WIN64
+    #include <fcntl.h>
+    #include <sys/file.h>
+    #include <sys/mman.h>
+#endif
+
+#include "Hash.h"
 #include "Path.h"
 
 std::string get_pwd();
@@ -17,4 +26,35 @@ int delDir(std::string dir);
 int cpDir(const std::string& sourceDir, const std::string& targetDir);
 int cpFile(const std::string& sourceFile, const std::string& targetFile);
 
+//size and modification time (in nanoseconds where available) of a file, (-1, -1) if it doesn't exist
+std::pair<long long int, long long int> file_stamp(const std::string& path);
+//hash of a file's contents, 0 if it can't be read
+unsigned long long int file_hash(const std::string& path);
+//reads the whole of a file in to contents, returns 1 if it can't be read
+int read_file(const std::string& path, std::string& contents);
+
+//a file mapped in to memory read only (read in to memory on Windows)
+struct MappedFile
+{
+    const char* data;
+    size_t size;
+    #if defined _WIN32 || defined _WIN64
+        std::string contents;
+    #endif
+
+    MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    //returns 1 if the file can't be read or is empty
+    int open(const std::string& path);
+    void close();
+};
+
+//waits for an exclusive lock on a lock file shared with other processes (eg. build shards), -1 if locking isn't available
+int lock_file(const std::string& lockPath);
+//removes the lock file and releases the lock from lock_file
+void unlock_file(int lockFD, const std::string& lockPath);
+
 #endif //FILE_SYSTEM_H_
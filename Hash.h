@@ -0,0 +1,24 @@
+#ifndef HASH_H_
+#define HASH_H_
+
+#include <string>
+
+//64-bit FNV-1a hash, stable across runs and platforms (unlike std::hash)
+//continues from hash so data can be hashed a piece at a time
+inline unsigned long long int fnv1a(const char* data, size_t size, unsigned long long int hash = 14695981039346656037ULL)
+{
+    for(size_t i=0; i<size; i++)
+    {
+        hash ^= (unsigned char)data[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+inline unsigned long long int fnv1a(const std::string& str)
+{
+    return fnv1a(str.c_str(), str.size());
+}
+
+#endif //HASH_H_
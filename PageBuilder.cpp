@@ -1,6 +1,7 @@
 #include "PageBuilder.h"
 
-std::atomic<long long int> sys_counter;
+//offset by process id so separate nsm processes (eg. build shards) don't share temporary file names
+std::atomic<long long int> sys_counter(getpid()*1000000000LL);
 
 bool is_whitespace(const std::string& str)
 {
@@ -26,11 +27,21 @@ std::string into_whitespace(const std::string& str)
     return whitespace;
 }
 
+//newest modification time (nanoseconds) of a range of paths
+template <class It>
+long long int newest_stamp(It first, It last)
+{
+    long long int newest = 0;
+    for(; first != last; first++)
+        newest = std::max(newest, statCache.stamp(first->str()).second);
+    return newest;
+}
+
 bool run_script(std::ostream& os, std::string scriptPath, std::mutex* os_mtx)
 {
     if(std::ifstream(scriptPath))
     {
-        int c = sys_counter++;
+        long long int c = sys_counter++;
         size_t pos = scriptPath.substr(1, scriptPath.size()-1).find_first_of('.');
         std::string cScriptExt = "";
         if(pos != std::string::npos)
@@ -112,7 +123,7 @@ bool run_script(std::ostream& os, std::string scriptPath, std::mutex* os_mtx)
     return 0;
 }
 
-PageBuilder::PageBuilder(std::set<PageInfo>* Pages,
+PageBuilder::PageBuilder(PageSet* Pages,
                          std::mutex* OS_mtx,
                          const Directory& ContentDir,
                          const Directory& SiteDir,
@@ -134,26 +145,33 @@ PageBuilder::PageBuilder(std::set<PageInfo>* Pages,
     defaultTemplate = DefaultTemplate;
     unixTextEditor = UnixTextEditor;
     winTextEditor = WinTextEditor;
+    parallelInputs = 0;
+    speculative = 0;
+    unchanged = 0;
+    depsBuildTime = 0;
+    depIndex = NULL;
+    pageIndex = NULL;
 }
 
 int PageBuilder::build(const PageInfo &PageToBuild, std::ostream& os)
 {
     sys_counter = sys_counter%1000000000000000000;
     pageToBuild = PageToBuild;
+    unchanged = 0;
 
     //os_mtx->lock();
     //os << std::endl;
     //os_mtx->unlock();
 
     //ensures content and template files exist
-    if(!std::ifstream(pageToBuild.contentPath.str()))
+    if(!statCache.exists(pageToBuild.contentPath.str()))
     {
         os_mtx->lock();
         os << "error: cannot build " << pageToBuild.pagePath << " as content file " << pageToBuild.contentPath << " does not exist" << std::endl;
         os_mtx->unlock();
         return 1;
     }
-    if(!std::ifstream(pageToBuild.templatePath.str()))
+    if(!statCache.exists(pageToBuild.templatePath.str()))
     {
         os_mtx->lock();
         os << "error: cannot build " << pageToBuild.pagePath << " as template file " << pageToBuild.templatePath << " does not exist." << std::endl;
@@ -161,23 +179,9 @@ int PageBuilder::build(const PageInfo &PageToBuild, std::ostream& os)
         return 1;
     }
 
-    //checks for non-default script extension
-    Path extPath = pageToBuild.pagePath.getInfoPath();
-    extPath.file = extPath.file.substr(0, extPath.file.find_first_of('.')) + ".scriptExt";
-
-    std::string pageScriptExt;
-    if(std::ifstream(extPath.str()))
-    {
-        std::ifstream ifs(extPath.str());
-        getline(ifs, pageScriptExt);
-        ifs.close();
-    }
-    else
-        pageScriptExt = scriptExt;
-
     //checks for pre-build scripts
     Path prebuildScript = pageToBuild.contentPath;
-    prebuildScript.file = prebuildScript.file.substr(0, prebuildScript.file.find_first_of('.')) + "-pre-build" + pageScriptExt;
+    prebuildScript.set_file(prebuildScript.file().substr(0, prebuildScript.file().find_first_of('.')) + "-pre-build" + pageToBuild.scriptExt);
     if(run_script(os, prebuildScript.str(), os_mtx))
         return 1;
 
@@ -185,30 +189,74 @@ int PageBuilder::build(const PageInfo &PageToBuild, std::ostream& os)
     //os << "building page " << pageToBuild.pagePath << std::endl;
     //os_mtx->unlock();
 
-    //makes sure variables are at default values
-    codeBlockDepth = htmlCommentDepth = 0;
-    indentAmount = "";
-    contentAdded = 0;
-    processedPage.clear();
-    processedPage.str(std::string());
-    pageDeps.clear();
-    strings.clear();
-    contentAdded = 0;
+    //pins build time to the newest modification time of the page's dependencies,
+    //starting from the dependencies of the last build and rendering again if this render read different ones
+    if(depsBuildTime)
+    {
+        std::vector<Path> lastDeps;
+        if(depIndex)
+            depIndex->last_deps(pageToBuild.pageName, lastDeps);
+        lastDeps.push_back(pageToBuild.contentPath);
+        lastDeps.push_back(pageToBuild.templatePath);
+        dateTimeInfo.set(newest_stamp(lastDeps.begin(), lastDeps.end())/1000000000);
+    }
+
+    int result;
+    for(int pass=0; ; pass++)
+    {
+        //makes sure variables are at default values
+        codeBlockDepth = htmlCommentDepth = 0;
+        indentAmount = "";
+        contentAdded = 0;
+        processedPage.clear();
+        processedPage.str(std::string());
+        pageDeps.clear();
+        pageRefs.clear();
+        configDeps.clear();
+        depParents.clear();
+        strings.clear();
+        contentAdded = 0;
+
+        //adds content and template paths to dependencies
+        add_dep(pageToBuild.contentPath);
+        add_dep(pageToBuild.templatePath);
+
+        //adds user-defined dependencies listed in a .deps file beside the content file
+        Path depsPath = pageToBuild.contentPath, dep;
+        depsPath.set_file(depsPath.file().substr(0, depsPath.file().find_first_of('.')) + ".deps");
+        if(statCache.exists(depsPath.str()))
+        {
+            add_dep(depsPath);
+            depParents.insert(std::make_pair(depsPath, pageToBuild.contentPath));
+
+            std::ifstream depsFile(depsPath.str());
+            while(dep.read_file_path_from(depsFile))
+            {
+                add_dep(dep);
+                depParents.insert(std::make_pair(dep, depsPath));
+            }
+        }
 
-    //adds content and template paths to dependencies
-    pageDeps.insert(pageToBuild.contentPath);
-    pageDeps.insert(pageToBuild.templatePath);
+        //reads the template file to start parsing from
+        std::string templateContents;
+        statCache.read(pageToBuild.templatePath.str(), templateContents);
+        std::istringstream ifs(templateContents);
 
-    //opens up template file to start parsing from
-    std::ifstream ifs(pageToBuild.templatePath.str());
+        //creates anti-deps of page template set
+        std::set<Path> antiDepsOfReadPath;
 
-    //creates anti-deps of page template set
-    std::set<Path> antiDepsOfReadPath;
+        //starts read_and_process from templatePath
+        result = read_and_process(1, ifs, pageToBuild.templatePath, antiDepsOfReadPath, processedPage, os);
 
-    //starts read_and_process from templatePath
-    int result = read_and_process(1, ifs, pageToBuild.templatePath, antiDepsOfReadPath, processedPage, os);
+        if(!depsBuildTime || result)
+            break;
 
-    ifs.close();
+        //gives up after a few passes in case the build time itself changes which files are read
+        time_t depsTime = newest_stamp(pageDeps.begin(), pageDeps.end())/1000000000;
+        if(depsTime == dateTimeInfo.buildTime || pass == 2)
+            break;
+        dateTimeInfo.set(depsTime);
+    }
 
     if(result == 0)
     {
@@ -221,39 +269,98 @@ int PageBuilder::build(const PageInfo &PageToBuild, std::ostream& os)
             return 1;
         }
 
-        //makes sure page file exists
-        pageToBuild.pagePath.ensurePathExists();
+        std::string pageStr = processedPage.str();
+        unsigned long long int outputHash = fnv1a("\n", 1, fnv1a(pageStr.c_str(), pageStr.size())),
+                               prevOutputHash;
+        std::pair<long long int, long long int> pageStamp, prevPageStamp;
 
-        //makes sure we can write to page file
-        chmod(pageToBuild.pagePath.str().c_str(), 0644);
+        //leaves page file untouched if it's still what was written last time and the output hasn't changed
+        if(depIndex && depIndex->last_output(pageToBuild.pageName, prevOutputHash, prevPageStamp) && prevOutputHash == outputHash)
+        {
+            pageStamp = file_stamp(pageToBuild.pagePath.str());
+            unchanged = (pageStamp == prevPageStamp);
+        }
 
-        //writes processed page to page file
-        std::ofstream pageStream(pageToBuild.pagePath.str());
-        pageStream << processedPage.str() << "\n";
-        pageStream.close();
+        if(!unchanged)
+        {
+            //makes sure page file exists
+            pageToBuild.pagePath.ensurePathExists();
 
-        //makes sure user can't accidentally write to page file
-        chmod(pageToBuild.pagePath.str().c_str(), 0444);
+            //makes sure we can write to page file
+            chmod(pageToBuild.pagePath.str().c_str(), 0644);
 
-        //gets path for storing page information
-        Path pageInfoPath = pageToBuild.pagePath.getInfoPath();
+            //writes processed page to page file
+            std::ofstream pageStream(pageToBuild.pagePath.str());
+            pageStream << pageStr << "\n";
+            pageStream.close();
 
-        //makes sure page info file exists
-        pageInfoPath.ensurePathExists();
+            //makes sure user can't accidentally write to page file
+            chmod(pageToBuild.pagePath.str().c_str(), 0444);
 
-        //makes sure we can write to info file_
-        chmod(pageInfoPath.str().c_str(), 0644);
+            if(depIndex)
+                pageStamp = file_stamp(pageToBuild.pagePath.str());
+        }
 
-        //writes page info file
-        std::ofstream infoStream(pageInfoPath.str());
-        infoStream << dateTimeInfo.currentTime() << " " << dateTimeInfo.currentDate() << "\n";
-        infoStream << this->pageToBuild << "\n\n";
-        for(auto pageDep=pageDeps.begin(); pageDep != pageDeps.end(); pageDep++)
-            infoStream << *pageDep << "\n";
-        infoStream.close();
+        //gets path for storing page information
+        Path pageInfoPath = pageToBuild.pagePath.getInfoPath();
 
-        //makes sure user can't accidentally write to info file
-        chmod(pageInfoPath.str().c_str(), 0444);
+        if(depIndex && depIndex->buildState)
+        {
+            //page information goes in the build state instead, removes info file left from before it was enabled
+            if(statCache.exists(pageInfoPath.str()))
+            {
+                chmod(pageInfoPath.str().c_str(), 0666);
+                pageInfoPath.removePath();
+            }
+        }
+        else
+        {
+            //makes sure page info file exists
+            pageInfoPath.ensurePathExists();
+
+            //makes sure we can write to info file_
+            chmod(pageInfoPath.str().c_str(), 0644);
+
+            //writes page info file
+            std::ofstream infoStream(pageInfoPath.str());
+            infoStream << dateTimeInfo.currentTime() << " " << dateTimeInfo.currentDate() << "\n";
+            infoStream << this->pageToBuild << "\n\n";
+            for(auto pageDep=pageDeps.begin(); pageDep != pageDeps.end(); pageDep++)
+                infoStream << *pageDep << "\n";
+            infoStream.close();
+
+            //makes sure user can't accidentally write to info file
+            chmod(pageInfoPath.str().c_str(), 0444);
+        }
+
+        //records the page's dependencies in the dependency index
+        if(depIndex)
+        {
+            DepIndexEntry entry;
+            if(depIndex->buildState)
+                entry.infoStamp = std::make_pair(0LL, (long long int)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+            else
+                entry.infoStamp = file_stamp(pageInfoPath.str());
+            entry.pageTitle = pageToBuild.pageTitle;
+            entry.templatePath = pageToBuild.templatePath;
+            entry.deps.assign(pageDeps.begin(), pageDeps.end());
+            entry.depParents.resize(entry.deps.size(), -1);
+            for(size_t d=0; d<entry.deps.size(); d++)
+            {
+                auto parent = depParents.find(entry.deps[d]);
+                if(parent == depParents.end())
+                    continue;
+                auto parentDep = std::lower_bound(entry.deps.begin(), entry.deps.end(), parent->second);
+                if(parentDep != entry.deps.end() && *parentDep == parent->second)
+                    entry.depParents[d] = parentDep - entry.deps.begin();
+            }
+            entry.pageRefs.assign(pageRefs.begin(), pageRefs.end());
+            entry.configDeps.assign(configDeps.begin(), configDeps.end());
+            depIndex->stamp_deps(entry, 1);
+            entry.outputHash = outputHash;
+            entry.pageStamp = pageStamp;
+            depIndex->update(pageToBuild.pageName, entry);
+        }
 
         //os_mtx->lock();
         //os << "page build successful" << std::endl;
@@ -262,7 +369,7 @@ int PageBuilder::build(const PageInfo &PageToBuild, std::ostream& os)
 
     //checks for post-build scripts
     Path postbuildScripts = pageToBuild.contentPath;
-    postbuildScripts.file = postbuildScripts.file.substr(0, postbuildScripts.file.find_first_of('.')) + "-post-build" + pageScriptExt;
+    postbuildScripts.set_file(postbuildScripts.file().substr(0, postbuildScripts.file().find_first_of('.')) + "-post-build" + pageToBuild.scriptExt);
     if(run_script(os, postbuildScripts.str(), os_mtx))
         return 1; //should a page be listed as failing to build if the post-build script fails?
 
@@ -288,7 +395,9 @@ int PageBuilder::read_and_process(const bool& indent,
     int baseCodeBlockDepth = codeBlockDepth;
 
     int lineNo = 0,
-        openCodeLineNo = 0;
+        openCodeLineNo = 0,
+        groupSize,
+        sequentialLines = 0;
     bool firstLine = 1, lastLine = 0;
     std::string inLine;
     while(getline(is, inLine))
@@ -348,6 +457,17 @@ int PageBuilder::read_and_process(const bool& indent,
         }
         firstLine = 0;
 
+        //renders consecutive lines that just input files concurrently when they're large enough
+        if(parallelInputs > 0)
+        {
+            if(sequentialLines > 0)
+                sequentialLines--;
+            else if(!read_input_group(indent, is, readPath, inLine, lineNo, groupSize, antiDepsOfReadPath, baseIndentAmount, os))
+                continue;
+            else
+                sequentialLines = groupSize - 1;
+        }
+
         for(size_t linePos=0; linePos<inLine.length();)
         {
             if(inLine[linePos] == '\\') //checks whether to escape
@@ -536,6 +656,15 @@ int PageBuilder::read_and_process(const bool& indent,
                         indentAmount += " ";
                     linePos++;
                 }
+                else if(speculative && (inLine.substr(linePos, 7) == "@string" ||
+                                        inLine.substr(linePos, 7) == "@userin" ||
+                                        inLine.substr(linePos, 11) == "@userfilein" ||
+                                        inLine.substr(linePos, 7) == "@script" ||
+                                        inLine.substr(linePos, 7) == "@system"))
+                {
+                    //these depend on or change what happens before/after them, so the line is rendered in order instead
+                    return 1;
+                }
                 else if(inLine.substr(linePos, 2) == "@#")
                 {
                     linePos = inLine.length();
@@ -679,7 +808,7 @@ int PageBuilder::read_and_process(const bool& indent,
                 else if(inLine.substr(linePos, 10) == "@inputhead")
                 {
                     Path headPath = pageToBuild.contentPath;
-                    headPath.file = headPath.file.substr(0, headPath.file.find_first_of('.')) + ".head";
+                    headPath.set_file(headPath.file().substr(0, headPath.file().find_first_of('.')) + ".head");
                     if(std::ifstream(headPath.str()))
                     {
                         std::string replaceText = "@input(" + quote(headPath.str()) + ")";
@@ -793,18 +922,7 @@ int PageBuilder::read_and_process(const bool& indent,
                     std::string output_filename = ".@userfilein" + std::to_string(sys_counter++);
                     int result;
 
-                    std::string contExtPath = ".siteinfo/" + siteDir + pageToBuild.pageName + ".ext";
-
-                    if(std::ifstream(contExtPath))
-                    {
-                        std::string ext;
-                        std::ifstream ifs(contExtPath);
-                        getline(ifs, ext);
-                        ifs.close();
-                        contExtPath += ext;
-                    }
-                    else
-                        output_filename += contentExt;
+                    output_filename += pageToBuild.contentExt;
 
                     os_mtx->lock();
                     std::ofstream ofs(output_filename);
@@ -903,13 +1021,15 @@ int PageBuilder::read_and_process(const bool& indent,
 
                     Path inputPath;
                     inputPath.set_file_path_from(inputPathStr);
-                    pageDeps.insert(inputPath);
+                    add_dep(inputPath);
+                    depParents.insert(std::make_pair(inputPath, readPath));
 
                     if(inputPath == pageToBuild.contentPath)
                         contentAdded = 1;
 
                     //ensures insert file exists
-                    if(!std::ifstream(inputPathStr))
+                    std::string inputContents;
+                    if(statCache.read(inputPath.str(), inputContents))
                     {
                         os_mtx->lock();
                         eos << "error: " << readPath << ": line " << lineNo << ": inputting file " << inputPath << " failed as path does not exist" << std::endl;
@@ -917,7 +1037,7 @@ int PageBuilder::read_and_process(const bool& indent,
                         return 1;
                     }
 
-                    std::ifstream ifs(inputPath.str());
+                    std::istringstream ifs(inputContents);
                     std::string fileLine, oldLine;
                     int fileLineNo = 0;
 
@@ -929,8 +1049,6 @@ int PageBuilder::read_and_process(const bool& indent,
                         os << fileLine;
                     }
                     indentAmount += into_whitespace(oldLine);
-
-                    ifs.close();
                 }
                 else if(inLine.substr(linePos, 7) == "@input(" || inLine.substr(linePos, 8) == "@input*(")
                 {
@@ -974,13 +1092,15 @@ int PageBuilder::read_and_process(const bool& indent,
 
                     Path inputPath;
                     inputPath.set_file_path_from(inputPathStr);
-                    pageDeps.insert(inputPath);
+                    add_dep(inputPath);
+                    depParents.insert(std::make_pair(inputPath, readPath));
 
                     if(inputPath == pageToBuild.contentPath)
                         contentAdded = 1;
 
                     //ensures insert file exists
-                    if(!std::ifstream(inputPathStr))
+                    std::string inputContents;
+                    if(statCache.read(inputPath.str(), inputContents))
                     {
                         os_mtx->lock();
                         eos << "error: " << readPath << ": line " << lineNo << ": inputting file " << inputPath << " failed as path does not exist" << std::endl;
@@ -996,9 +1116,9 @@ int PageBuilder::read_and_process(const bool& indent,
                         return 1;
                     }
 
-                    std::ifstream ifs(inputPath.str());
 
                     //adds insert file
+                    std::istringstream ifs(inputContents);
                     if(read_and_process(1, ifs, inputPath, antiDepsOfReadPath, os, eos) > 0)
                     {
                         os_mtx->lock();
@@ -1007,8 +1127,6 @@ int PageBuilder::read_and_process(const bool& indent,
                         return 1;
                     }
                     //indent amount updated inside read_and_process
-
-                    ifs.close();
                 }
                 else if(inLine.substr(linePos, 5) == "@dep(" || inLine.substr(linePos, 6) == "@dep*(")
                 {
@@ -1052,7 +1170,8 @@ int PageBuilder::read_and_process(const bool& indent,
 
                     Path depPath;
                     depPath.set_file_path_from(depPathStr);
-                    pageDeps.insert(depPath);
+                    add_dep(depPath);
+                    depParents.insert(std::make_pair(depPath, readPath));
 
                     if(depPath == pageToBuild.contentPath)
                         contentAdded = 1;
@@ -1067,7 +1186,7 @@ int PageBuilder::read_and_process(const bool& indent,
                 }
                 else if(inLine.substr(linePos, 8) == "@script(" || inLine.substr(linePos, 9) == "@script*(")
                 {
-                    int c = sys_counter++;
+                    long long int c = sys_counter++;
                     linePos+=std::string("@script").length();
                     std::string scriptPathStr, scriptParams;
                     std::string output_filename = ".@scriptoutput" + std::to_string(c);
@@ -1139,7 +1258,8 @@ int PageBuilder::read_and_process(const bool& indent,
 
                     Path scriptPath;
                     scriptPath.set_file_path_from(scriptPathStr);
-                    pageDeps.insert(scriptPath);
+                    add_dep(scriptPath);
+                    depParents.insert(std::make_pair(scriptPath, readPath));
 
                     if(!std::ifstream(scriptPathStr))
                     {
@@ -1215,7 +1335,7 @@ int PageBuilder::read_and_process(const bool& indent,
                 }
                 else if(inLine.substr(linePos, 11) == "@scriptraw(" || inLine.substr(linePos, 12) == "@scriptraw*(")
                 {
-                    int c = sys_counter++;
+                    long long int c = sys_counter++;
                     linePos+=std::string("@scriptraw").length();
                     std::string scriptPathStr, scriptParams;
                     std::string output_filename = ".@scriptoutput" + std::to_string(c);
@@ -1287,7 +1407,8 @@ int PageBuilder::read_and_process(const bool& indent,
 
                     Path scriptPath;
                     scriptPath.set_file_path_from(scriptPathStr);
-                    pageDeps.insert(scriptPath);
+                    add_dep(scriptPath);
+                    depParents.insert(std::make_pair(scriptPath, readPath));
 
                     if(scriptPath == pageToBuild.contentPath)
                         contentAdded = 1;
@@ -1375,7 +1496,7 @@ int PageBuilder::read_and_process(const bool& indent,
                 }
                 else if(inLine.substr(linePos, 14) == "@scriptoutput(" || inLine.substr(linePos, 15) == "@scriptoutput*(")
                 {
-                    int c = sys_counter++;
+                    long long int c = sys_counter++;
                     linePos+=std::string("@scriptoutput").length();
                     std::string scriptPathStr, scriptParams;
                     std::string output_filename = ".@scriptoutput" + std::to_string(c);
@@ -1447,7 +1568,8 @@ int PageBuilder::read_and_process(const bool& indent,
 
                     Path scriptPath;
                     scriptPath.set_file_path_from(scriptPathStr);
-                    pageDeps.insert(scriptPath);
+                    add_dep(scriptPath);
+                    depParents.insert(std::make_pair(scriptPath, readPath));
 
                     if(scriptPath == pageToBuild.contentPath)
                         contentAdded = 1;
@@ -2026,7 +2148,11 @@ int PageBuilder::read_and_process(const bool& indent,
                     //throws error if target targetPageName isn't being tracked by Nift
                     PageInfo targetPageInfo;
                     targetPageInfo.pageName = targetPageName;
-                    if(!pages->count(targetPageInfo))
+                    auto targetPage = pages->find(targetPageInfo);
+                    Path targetPath;
+                    if(targetPage != pages->end())
+                        targetPath = targetPage->pagePath;
+                    else if(!pageIndex || !pageIndex->find_page_path(targetPageName, siteDir, pageExt, targetPath))
                     {
                         os_mtx->lock();
                         eos << "error: " << readPath << ": line " << lineNo << ": @pathto(" << targetPageName << ") failed, Nift not tracking " << targetPageName << std::endl;
@@ -2034,11 +2160,10 @@ int PageBuilder::read_and_process(const bool& indent,
                         return 1;
                     }
 
-
-                    Path targetPath = pages->find(targetPageInfo)->pagePath;
                     //targetPath.set_file_path_from(targetPathStr);
+                    pageRefs[targetPageName] = targetPath;
 
-                    Path pathToTarget(pathBetween(pageToBuild.pagePath.dir, targetPath.dir), targetPath.file);
+                    Path pathToTarget = path_between(pageToBuild.pagePath, targetPath);
 
                     //adds path to target
                     os << pathToTarget.str();
@@ -2088,7 +2213,11 @@ int PageBuilder::read_and_process(const bool& indent,
                     //throws error if target targetPageName isn't being tracked by Nift
                     PageInfo targetPageInfo;
                     targetPageInfo.pageName = targetPageName;
-                    if(!pages->count(targetPageInfo))
+                    auto targetPage = pages->find(targetPageInfo);
+                    Path targetPath;
+                    if(targetPage != pages->end())
+                        targetPath = targetPage->pagePath;
+                    else if(!pageIndex || !pageIndex->find_page_path(targetPageName, siteDir, pageExt, targetPath))
                     {
                         os_mtx->lock();
                         eos << "error: " << readPath << ": line " << lineNo << ": @pathtopage(" << targetPageName << ") failed, Nift not tracking " << targetPageName << std::endl;
@@ -2096,11 +2225,10 @@ int PageBuilder::read_and_process(const bool& indent,
                         return 1;
                     }
 
-
-                    Path targetPath = pages->find(targetPageInfo)->pagePath;
                     //targetPath.set_file_path_from(targetPathStr);
+                    pageRefs[targetPageName] = targetPath;
 
-                    Path pathToTarget(pathBetween(pageToBuild.pagePath.dir, targetPath.dir), targetPath.file);
+                    Path pathToTarget = path_between(pageToBuild.pagePath, targetPath);
 
                     //adds path to target
                     os << pathToTarget.str();
@@ -2158,7 +2286,7 @@ int PageBuilder::read_and_process(const bool& indent,
                     Path targetPath;
                     targetPath.set_file_path_from(targetFilePath);
 
-                    Path pathToTarget(pathBetween(pageToBuild.pagePath.dir, targetPath.dir), targetPath.file);
+                    Path pathToTarget = path_between(pageToBuild.pagePath, targetPath);
 
                     //adds path to target
                     os << pathToTarget.str();
@@ -2195,28 +2323,12 @@ int PageBuilder::read_and_process(const bool& indent,
                 }
                 else if(inLine.substr(linePos, 12) == "@pagepageext")
                 {
-                    //checks for non-default page extension
-                    Path extPath = pageToBuild.pagePath.getInfoPath();
-                    extPath.file = extPath.file.substr(0, extPath.file.find_first_of('.')) + ".pageExt";
-
-                    if(std::ifstream(extPath.str()))
-                    {
-                        std::string ext;
-
-                        std::ifstream ifs(extPath.str());
-                        getline(ifs, ext);
-                        ifs.close();
-
-                        os << ext;
-                        if(indent)
-                            indentAmount += into_whitespace(ext);
-                    }
-                    else
-                    {
-                        os << pageExt;
-                        if(indent)
-                            indentAmount += into_whitespace(pageExt);
-                    }
+                    os << pageToBuild.pageExt;
+                    if(indent)
+                        indentAmount += into_whitespace(pageToBuild.pageExt);
+                    //pages which haven't overridden the extension depend on the config key
+                    if(pageToBuild.pageExt == pageExt)
+                        configDeps["pageExt"] = pageExt;
 
                     linePos += std::string("@pagepageext").length();
                 }
@@ -2229,55 +2341,21 @@ int PageBuilder::read_and_process(const bool& indent,
                 }
                 else if(inLine.substr(linePos, 15) == "@pagecontentext")
                 {
-                    //checks for non-default content extension
-                    Path extPath = pageToBuild.pagePath.getInfoPath();
-                    extPath.file = extPath.file.substr(0, extPath.file.find_first_of('.')) + ".contExt";
-
-                    if(std::ifstream(extPath.str()))
-                    {
-                        std::string ext;
-
-                        std::ifstream ifs(extPath.str());
-                        getline(ifs, ext);
-                        ifs.close();
-
-                        os << ext;
-                        if(indent)
-                            indentAmount += into_whitespace(ext);
-                    }
-                    else
-                    {
-                        os << contentExt;
-                        if(indent)
-                            indentAmount += into_whitespace(contentExt);
-                    }
+                    os << pageToBuild.contentExt;
+                    if(indent)
+                        indentAmount += into_whitespace(pageToBuild.contentExt);
+                    if(pageToBuild.contentExt == contentExt)
+                        configDeps["contentExt"] = contentExt;
 
                     linePos += std::string("@pagecontentext").length();
                 }
                 else if(inLine.substr(linePos, 14) == "@pagescriptext")
                 {
-                    //checks for non-default script extension
-                    Path extPath = pageToBuild.pagePath.getInfoPath();
-                    extPath.file = extPath.file.substr(0, extPath.file.find_first_of('.')) + ".scriptExt";
-
-                    if(std::ifstream(extPath.str()))
-                    {
-                        std::string ext;
-
-                        std::ifstream ifs(extPath.str());
-                        getline(ifs, ext);
-                        ifs.close();
-
-                        os << ext;
-                        if(indent)
-                            indentAmount += into_whitespace(ext);
-                    }
-                    else
-                    {
-                        os << scriptExt;
-                        if(indent)
-                            indentAmount += into_whitespace(scriptExt);
-                    }
+                    os << pageToBuild.scriptExt;
+                    if(indent)
+                        indentAmount += into_whitespace(pageToBuild.scriptExt);
+                    if(pageToBuild.scriptExt == scriptExt)
+                        configDeps["scriptExt"] = scriptExt;
 
                     linePos += std::string("@pagescriptext").length();
                 }
@@ -2290,6 +2368,7 @@ int PageBuilder::read_and_process(const bool& indent,
                 }
                 else if(inLine.substr(linePos, 11) == "@contentdir")
                 {
+                    configDeps["contentDir"] = contentDir;
                     if(contentDir.size() && (contentDir[contentDir.size()-1] == '/' || contentDir[contentDir.size()-1] == '\\'))
                     {
                         os << contentDir.substr(0, contentDir.size()-1);
@@ -2306,6 +2385,7 @@ int PageBuilder::read_and_process(const bool& indent,
                 }
                 else if(inLine.substr(linePos, 8) == "@sitedir")
                 {
+                    configDeps["siteDir"] = siteDir;
                     if(siteDir.size() && (siteDir[siteDir.size()-1] == '/' || siteDir[siteDir.size()-1] == '\\'))
                     {
                         os << siteDir.substr(0, siteDir.size()-1);
@@ -2325,6 +2405,7 @@ int PageBuilder::read_and_process(const bool& indent,
                     os << contentExt;
                     if(indent)
                         indentAmount += into_whitespace(contentExt);
+                    configDeps["contentExt"] = contentExt;
                     linePos += std::string("@contentext").length();
                 }
                 else if(inLine.substr(linePos, 8) == "@pageext")
@@ -2332,6 +2413,7 @@ int PageBuilder::read_and_process(const bool& indent,
                     os << pageExt;
                     if(indent)
                         indentAmount += into_whitespace(pageExt);
+                    configDeps["pageExt"] = pageExt;
                     linePos += std::string("@pageExt").length();
                 }
                 else if(inLine.substr(linePos, 10) == "@scriptext")
@@ -2339,6 +2421,7 @@ int PageBuilder::read_and_process(const bool& indent,
                     os << scriptExt;
                     if(indent)
                         indentAmount += into_whitespace(scriptExt);
+                    configDeps["scriptExt"] = scriptExt;
                     linePos += std::string("@scriptExt").length();
                 }
                 else if(inLine.substr(linePos, 16) == "@defaulttemplate")
@@ -2346,6 +2429,7 @@ int PageBuilder::read_and_process(const bool& indent,
                     os << defaultTemplate.str();
                     if(indent)
                         indentAmount += into_whitespace(defaultTemplate.str());
+                    configDeps["defaultTemplate"] = defaultTemplate.str();
                     linePos += std::string("@defaulttemplate").length();
                 }
                 else if(inLine.substr(linePos, 14) == "@buildtimezone")
@@ -2378,9 +2462,9 @@ int PageBuilder::read_and_process(const bool& indent,
                 }
                 else if(inLine.substr(linePos, 13) == "@buildUTCtime")
                 {
-                    os << dateTimeInfo.currentUTCTime();
+                    os << dateTimeInfo.cUTCTime;
                     if(indent)
-                        indentAmount += into_whitespace(dateTimeInfo.currentUTCTime());
+                        indentAmount += into_whitespace(dateTimeInfo.cUTCTime);
                     linePos += std::string("@buildUTCtime").length();
                 }
                 else if(inLine.substr(linePos, 10) == "@builddate")
@@ -2392,9 +2476,9 @@ int PageBuilder::read_and_process(const bool& indent,
                 }
                 else if(inLine.substr(linePos, 13) == "@buildUTCdate")
                 {
-                    os << dateTimeInfo.currentUTCDate();
+                    os << dateTimeInfo.cUTCDate;
                     if(indent)
-                        indentAmount += into_whitespace(dateTimeInfo.currentUTCDate());
+                        indentAmount += into_whitespace(dateTimeInfo.cUTCDate);
                     linePos += std::string("@buildUTCdate").length();
                 }
                 else if(inLine.substr(linePos, 12) == "@currenttime")
@@ -2406,9 +2490,9 @@ int PageBuilder::read_and_process(const bool& indent,
                 }
                 else if(inLine.substr(linePos, 15) == "@currentUTCtime")
                 { //this is left for backwards compatibility
-                    os << dateTimeInfo.currentUTCTime();
+                    os << dateTimeInfo.cUTCTime;
                     if(indent)
-                        indentAmount += into_whitespace(dateTimeInfo.currentUTCTime());
+                        indentAmount += into_whitespace(dateTimeInfo.cUTCTime);
                     linePos += std::string("@currentUTCtime").length();
                 }
                 else if(inLine.substr(linePos, 12) == "@currentdate")
@@ -2420,9 +2504,9 @@ int PageBuilder::read_and_process(const bool& indent,
                 }
                 else if(inLine.substr(linePos, 15) == "@currentUTCdate")
                 { //this is left for backwards compatibility
-                    os << dateTimeInfo.currentUTCDate();
+                    os << dateTimeInfo.cUTCDate;
                     if(indent)
-                        indentAmount += into_whitespace(dateTimeInfo.currentUTCDate());
+                        indentAmount += into_whitespace(dateTimeInfo.cUTCDate);
                     linePos += std::string("@currentUTCdate").length();
                 }
                 else if(inLine.substr(linePos, 9) == "@loadtime")
@@ -2455,30 +2539,30 @@ int PageBuilder::read_and_process(const bool& indent,
                 }
                 else if(inLine.substr(linePos, 10) == "@buildYYYY")
                 {
-                    os << dateTimeInfo.currentYYYY();
+                    os << dateTimeInfo.cYYYY;
                     if(indent)
-                        indentAmount += into_whitespace(dateTimeInfo.currentYYYY());
+                        indentAmount += into_whitespace(dateTimeInfo.cYYYY);
                     linePos += std::string("@buildYYYY").length();
                 }
                 else if(inLine.substr(linePos, 8) == "@buildYY")
                 {
-                    os << dateTimeInfo.currentYY();
+                    os << dateTimeInfo.cYY;
                     if(indent)
-                        indentAmount += into_whitespace(dateTimeInfo.currentYY());
+                        indentAmount += into_whitespace(dateTimeInfo.cYY);
                     linePos += std::string("@buildYY").length();
                 }
                 else if(inLine.substr(linePos, 12) == "@currentYYYY")
                 { //this is left for backwards compatibility
-                    os << dateTimeInfo.currentYYYY();
+                    os << dateTimeInfo.cYYYY;
                     if(indent)
-                        indentAmount += into_whitespace(dateTimeInfo.currentYYYY());
+                        indentAmount += into_whitespace(dateTimeInfo.cYYYY);
                     linePos += std::string("@currentYYYY").length();
                 }
                 else if(inLine.substr(linePos, 10) == "@currentYY")
                 { //this is left for backwards compatibility
-                    os << dateTimeInfo.currentYY();
+                    os << dateTimeInfo.cYY;
                     if(indent)
-                        indentAmount += into_whitespace(dateTimeInfo.currentYY());
+                        indentAmount += into_whitespace(dateTimeInfo.cYY);
                     linePos += std::string("@currentYY").length();
                 }
                 else if(inLine.substr(linePos, 9) == "@loadYYYY")
@@ -2560,7 +2644,7 @@ int PageBuilder::read_and_process(const bool& indent,
                     Path faviconPath;
                     faviconPath.set_file_path_from(faviconPathStr);
 
-                    Path pathToFavicon(pathBetween(pageToBuild.pagePath.dir, faviconPath.dir), faviconPath.file);
+                    Path pathToFavicon = path_between(pageToBuild.pagePath, faviconPath);
 
                     std::string faviconInclude = "<link rel='icon' type='image/png' href='";
                     faviconInclude += pathToFavicon.str();
@@ -2621,7 +2705,7 @@ int PageBuilder::read_and_process(const bool& indent,
                     Path cssPath;
                     cssPath.set_file_path_from(cssPathStr);
 
-                    Path pathToCSSFile(pathBetween(pageToBuild.pagePath.dir, cssPath.dir), cssPath.file);
+                    Path pathToCSSFile = path_between(pageToBuild.pagePath, cssPath);
 
                     std::string cssInclude = "<link rel='stylesheet' type='text/css' href='";
                     cssInclude += pathToCSSFile.str();
@@ -2682,7 +2766,7 @@ int PageBuilder::read_and_process(const bool& indent,
                     Path imgPath;
                     imgPath.set_file_path_from(imgPathStr);
 
-                    Path pathToIMGFile(pathBetween(pageToBuild.pagePath.dir, imgPath.dir), imgPath.file);
+                    Path pathToIMGFile = path_between(pageToBuild.pagePath, imgPath);
 
                     std::string imgInclude = "<img src=\"" + pathToIMGFile.str() + "\">";
 
@@ -2741,7 +2825,7 @@ int PageBuilder::read_and_process(const bool& indent,
                     Path jsPath;
                     jsPath.set_file_path_from(jsPathStr);
 
-                    Path pathToJSFile(pathBetween(pageToBuild.pagePath.dir, jsPath.dir), jsPath.file);
+                    Path pathToJSFile = path_between(pageToBuild.pagePath, jsPath);
 
                     //the type attribute is unnecessary for JavaScript resources.
                     //std::string jsInclude="<script type='text/javascript' src='";
@@ -2786,6 +2870,194 @@ int PageBuilder::read_and_process(const bool& indent,
     return 0;
 }
 
+//adds a dependency before it's read, stamping it then so changes made while the page builds are picked up next time
+void PageBuilder::add_dep(const Path& depPath)
+{
+    if(pageDeps.insert(depPath).second && depIndex)
+        statCache.stamp(depPath.str());
+}
+
+//checks whether a line is just whitespace followed by @input(path)
+bool PageBuilder::input_line(const std::string& inLine,
+                             std::string& whitespace,
+                             std::string& inputPathStr)
+{
+    size_t linePos = inLine.find_first_not_of(" \t");
+
+    if(linePos == std::string::npos || inLine.substr(linePos, 7) != "@input(")
+        return 0;
+
+    whitespace = inLine.substr(0, linePos);
+    linePos += 7;
+
+    std::ostringstream ignored;
+    if(read_path(inputPathStr, linePos, inLine, Path("", ""), 0, "@input()", ignored) > 0)
+        return 0;
+
+    return linePos == inLine.size();
+}
+
+/*
+    renders a run of consecutive lines which just input files on separate
+    threads then writes them out in order. returns 1 if the run isn't large
+    enough or anything in it depends on the order lines are rendered in, in
+    which case the stream is back at the line after inLine and groupSize is
+    the number of lines in the run
+*/
+int PageBuilder::read_input_group(const bool& indent,
+                                  std::istream& is,
+                                  const Path& readPath,
+                                  const std::string& inLine,
+                                  int& lineNo,
+                                  int& groupSize,
+                                  const std::set<Path>& antiDepsOfReadPath,
+                                  const std::string& baseIndentAmount,
+                                  std::ostream& os)
+{
+    std::vector<std::string> whitespace;
+    std::vector<Path> inputPaths;
+    std::string ws, inputPathStr, nextLine;
+    Path inputPath;
+    std::pair<long long int, long long int> inputStamp;
+    long long int groupBytes = 0;
+
+    groupSize = 1;
+
+    if(!input_line(inLine, ws, inputPathStr))
+        return 1;
+
+    std::streampos groupPos = is.tellg(),
+                   pos = groupPos;
+    if(groupPos == std::streampos(-1))
+        return 1;
+
+    //reads lines until one isn't an @input line of an existing file (which gets put back)
+    for(const std::string* cLine = &inLine; ; cLine = &nextLine)
+    {
+        if(!input_line(*cLine, ws, inputPathStr))
+            break;
+
+        //stamped before any of the run is read, the same as other dependencies
+        inputPath.set_file_path_from(inputPathStr);
+        inputStamp = statCache.stamp(inputPathStr);
+        if(antiDepsOfReadPath.count(inputPath) || inputStamp.second < 0)
+            break;
+
+        whitespace.push_back(ws);
+        inputPaths.push_back(inputPath);
+        groupBytes += inputStamp.first;
+
+        pos = is.tellg();
+        if(pos == std::streampos(-1) || !getline(is, nextLine))
+            break;
+    }
+    is.clear();
+    if(pos != std::streampos(-1))
+        is.seekg(pos);
+    groupSize = std::max((int)inputPaths.size(), 1);
+
+    if(inputPaths.size() < 2 || groupBytes < parallelInputs)
+    {
+        is.seekg(groupPos);
+        return 1;
+    }
+
+    size_t noInputs = inputPaths.size();
+    std::vector<std::string> outputs(noInputs), indents(noInputs);
+    std::vector<std::set<Path> > deps(noInputs);
+    std::vector<std::map<Name, Path> > refs(noInputs);
+    std::vector<std::map<std::string, std::string> > configs(noInputs);
+    std::vector<std::map<Path, Path> > parents(noInputs);
+    std::vector<int> results(noInputs), htmlDepths(noInputs);
+    std::vector<char> addedContent(noInputs);
+    std::atomic<size_t> next(0);
+
+    //renders inputs taken in order, each starting from the state at the start of the run
+    auto render = [&]()
+    {
+        PageBuilder child(pages, os_mtx, contentDir, siteDir, contentExt, pageExt, scriptExt, defaultTemplate, unixTextEditor, winTextEditor);
+        child.pageToBuild = pageToBuild;
+        child.dateTimeInfo = dateTimeInfo;
+        child.depIndex = depIndex;
+        child.pageIndex = pageIndex;
+        child.speculative = 1;
+        std::ostringstream childOs, childEos;
+
+        for(size_t i = next++; i < noInputs; i = next++)
+        {
+            child.codeBlockDepth = codeBlockDepth;
+            child.htmlCommentDepth = htmlCommentDepth;
+            if(i == 0)
+                child.indentAmount = indentAmount;
+            else
+                child.indentAmount = baseIndentAmount;
+            if(indent)
+                child.indentAmount += whitespace[i];
+            child.strings = strings;
+            child.contentAdded = 0;
+            child.pageDeps.clear();
+            child.pageRefs.clear();
+            child.configDeps.clear();
+            child.depParents.clear();
+            childOs.str("");
+            childOs.clear();
+
+            std::string inputContents;
+            statCache.read(inputPaths[i].str(), inputContents);
+            std::istringstream ifs(inputContents);
+            results[i] = child.read_and_process(1, ifs, inputPaths[i], antiDepsOfReadPath, childOs, childEos);
+
+            outputs[i] = childOs.str();
+            indents[i] = child.indentAmount;
+            htmlDepths[i] = child.htmlCommentDepth;
+            deps[i].swap(child.pageDeps);
+            refs[i].swap(child.pageRefs);
+            configs[i].swap(child.configDeps);
+            parents[i].swap(child.depParents);
+            addedContent[i] = child.contentAdded;
+        }
+    };
+
+    size_t noThreads = std::min(noInputs, (size_t)std::max(1U, std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for(size_t t=1; t<noThreads; t++)
+        threads.push_back(std::thread(render));
+    render();
+    for(size_t t=0; t<threads.size(); t++)
+        threads[t].join();
+
+    //falls back to rendering in order if any input failed or left an html comment open
+    for(size_t i=0; i<noInputs; i++)
+    {
+        if(results[i] || htmlDepths[i] != htmlCommentDepth)
+        {
+            is.clear();
+            is.seekg(groupPos);
+            return 1;
+        }
+    }
+
+    for(size_t i=0; i<noInputs; i++)
+    {
+        if(i)
+            os << "\n" << baseIndentAmount;
+        os << whitespace[i] << outputs[i];
+
+        pageDeps.insert(inputPaths[i]);
+        pageDeps.insert(deps[i].begin(), deps[i].end());
+        depParents.insert(std::make_pair(inputPaths[i], readPath));
+        depParents.insert(parents[i].begin(), parents[i].end());
+        pageRefs.insert(refs[i].begin(), refs[i].end());
+        configDeps.insert(configs[i].begin(), configs[i].end());
+        if(addedContent[i] || inputPaths[i] == pageToBuild.contentPath)
+            contentAdded = 1;
+    }
+    indentAmount = indents[noInputs-1];
+    lineNo += noInputs - 1;
+
+    return 0;
+}
+
 int PageBuilder::read_path(std::string& pathRead,
                            size_t& linePos,
                            const std::string& inLine,
@@ -2,14 +2,20 @@
 #define PAGE_BUILDER_H_
 
 #include <atomic>
+#include <chrono>
 #include <map>
 #include <mutex>
 #include <sstream>
 #include <set>
+#include <thread>
 
 #include "DateTimeInfo.h"
+#include "DepIndex.h"
+#include "DirCache.h"
 #include "FileSystem.h"
-#include "PageInfo.h"
+#include "PageIndex.h"
+#include "PageSet.h"
+#include "StatCache.h"
 
 bool is_whitespace(const std::string& str);
 std::string into_whitespace(const std::string& str);
@@ -18,7 +24,7 @@ bool run_script(std::ostream& os, std::string scriptPath, std::mutex* os_mtx);
 struct PageBuilder
 {
 	std::mutex* os_mtx;
-    std::set<PageInfo>* pages;
+    PageSet* pages;
     PageInfo pageToBuild;
     DateTimeInfo dateTimeInfo;
     int codeBlockDepth,
@@ -28,7 +34,16 @@ struct PageBuilder
     std::stringstream processedPage;
     std::ostringstream oss;
     std::set<Path> pageDeps;
+    std::map<Name, Path> pageRefs; //pages linked to with @pathto/@pathtopage and their page paths when built
+    std::map<std::string, std::string> configDeps; //config keys read with @contentdir, @pageext etc. and their values when built
+    std::map<Path, Path> depParents; //file each dependency was first read from
     std::map<std::string, std::string> strings;
+    int parallelInputs; //bytes of consecutive @input lines needed to render them in parallel, 0 is off
+    bool speculative; //rendering an @input line in parallel, bails on anything order dependent
+    bool unchanged; //whether the last page built had the same output as before, so its page file was left untouched
+    bool depsBuildTime; //pins each page's build time to the newest modification time of its dependencies
+    DepIndex* depIndex; //records dependencies of built pages when set
+    PageIndex* pageIndex; //finds pages linked to which aren't in pages (eg. when building in batches) when set
 
     //site info
     Directory contentDir,
@@ -40,7 +55,7 @@ struct PageBuilder
                 winTextEditor;
     Path defaultTemplate;
 
-    PageBuilder(std::set<PageInfo>* Pages,
+    PageBuilder(PageSet* Pages,
                 std::mutex* OS_mtx,
                 const Directory& ContentDir,
                 const Directory& SiteDir,
@@ -58,6 +73,19 @@ struct PageBuilder
                          std::set<Path> antiDepsOfReadPath,
                          std::ostream& os,
                          std::ostream& eos);
+    void add_dep(const Path& depPath);
+    bool input_line(const std::string& inLine,
+                    std::string& whitespace,
+                    std::string& inputPathStr);
+    int read_input_group(const bool& indent,
+                         std::istream& is,
+                         const Path& readPath,
+                         const std::string& inLine,
+                         int& lineNo,
+                         int& groupSize,
+                         const std::set<Path>& antiDepsOfReadPath,
+                         const std::string& baseIndentAmount,
+                         std::ostream& os);
 
     int read_path(std::string& pathRead,
                   size_t& linePos,
@@ -0,0 +1,265 @@
+#include "PageIndex.h"
+
+/*
+    .siteinfo/pages.index format:
+
+    "nsm-pages-index 1\n" followed by the size and modification time (in
+    nanoseconds) of the pages.list it indexes, the number of pages, then
+    the offset in pages.list of each page's entry followed by the size of
+    pages.list, each 8 bytes in native byte order. written along with
+    pages.list, an index for a different pages.list (eg. one edited by
+    hand) is ignored and worked out again
+*/
+
+const std::string pageIndexHeader = "nsm-pages-index 1\n";
+
+int PageIndex::open()
+{
+    noPages = 0;
+
+    //may be reopening once the index has been saved
+    indexIfs.close();
+    listIfs.close();
+    indexIfs.clear();
+    listIfs.clear();
+
+    indexIfs.open(".siteinfo/pages.index", std::ios::binary);
+    listIfs.open(".siteinfo/pages.list", std::ios::binary);
+    if(!indexIfs || !listIfs)
+        return 1;
+
+    std::string header(pageIndexHeader.size(), '\0');
+    long long int listSize, listMTime;
+    unsigned long long int inNoPages;
+    if(!indexIfs.read(&header[0], header.size()) || header != pageIndexHeader ||
+       !indexIfs.read((char*)&listSize, sizeof(listSize)) ||
+       !indexIfs.read((char*)&listMTime, sizeof(listMTime)) ||
+       !indexIfs.read((char*)&inNoPages, sizeof(inNoPages)))
+        return 1;
+
+    if(file_stamp(".siteinfo/pages.list") != std::make_pair(listSize, listMTime))
+        return 1;
+
+    //checks the index isn't cut short
+    indexIfs.seekg(0, std::ios::end);
+    if((unsigned long long int)indexIfs.tellg() != header.size() + 3*8 + (inNoPages + 1)*8)
+        return 1;
+
+    noPages = inNoPages;
+
+    return 0;
+}
+
+unsigned long long int PageIndex::offset(const size_t& p)
+{
+    unsigned long long int pOffset = 0;
+
+    indexIfs.seekg(pageIndexHeader.size() + 3*8 + p*8);
+    indexIfs.read((char*)&pOffset, sizeof(pOffset));
+
+    return pOffset;
+}
+
+std::string PageIndex::entries(const size_t& p, const size_t& q)
+{
+    unsigned long long int start = offset(p),
+                           end = offset(q);
+    std::string entriesStr;
+
+    if(end <= start)
+        return entriesStr;
+
+    entriesStr.resize(end - start);
+    listIfs.seekg(start);
+    listIfs.read(&entriesStr[0], entriesStr.size());
+    entriesStr.resize(listIfs.gcount());
+
+    return entriesStr;
+}
+
+std::string PageIndex::key(const size_t& p)
+{
+    std::string entry = entries(p, p+1),
+                name;
+    const char* pos = entry.c_str();
+
+    read_quoted(pos, pos + entry.size(), name);
+
+    return quote(name);
+}
+
+size_t PageIndex::lower_bound(const std::string& key)
+{
+    size_t first = 0,
+           last = noPages;
+
+    while(first < last)
+    {
+        size_t middle = first + (last - first)/2;
+        if(this->key(middle) < key)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+
+    return first;
+}
+
+int PageIndex::read_journal()
+{
+    std::string data,
+                inType;
+    Name inName;
+    if(read_file(".siteinfo/pages.journal", data))
+        return 0;
+
+    const char *pos = data.c_str(),
+               *end = pos + data.size(),
+               *entry;
+    while(read_quoted(pos, end, inType))
+    {
+        while(pos < end && std::isspace((unsigned char)*pos))
+            pos++;
+        entry = pos;
+
+        if(inType == "+" && read_entry_name(pos, end, inName))
+            journal[quote(inName)].assign(entry, pos);
+        else if(inType == "-" && read_quoted(pos, end, inName))
+            journal[quote(inName)].clear();
+        else
+            break;
+    }
+
+    return 0;
+}
+
+bool PageIndex::find_entry(const std::string& key, std::string& entry)
+{
+    std::lock_guard<std::mutex> lock(mtx);
+
+    auto change = journal.find(key);
+    if(change != journal.end())
+    {
+        entry = change->second;
+        return entry.size();
+    }
+
+    size_t p = lower_bound(key);
+    if(p == noPages || this->key(p) != key)
+        return 0;
+
+    entry = entries(p, p+1);
+
+    return 1;
+}
+
+bool PageIndex::find_page_path(const Name& pageName, const Directory& siteDir, const std::string& pageExt, Path& pagePath)
+{
+    std::string key = quote(pageName),
+                entry,
+                inTitle,
+                inTemplatePath;
+    Name inName;
+    PageInfo page;
+
+    //pages linked to from many pages (eg. in a template) are only looked up once
+    {
+        std::lock_guard<std::mutex> lock(mtx);
+        auto found = pagePaths.find(key);
+        if(found != pagePaths.end())
+        {
+            pagePath = found->second;
+            return 1;
+        }
+    }
+
+    if(!find_entry(key, entry))
+        return 0;
+
+    const char *pos = entry.c_str(),
+               *end = pos + entry.size();
+    if(!read_quoted(pos, end, inName) ||
+       !read_quoted(pos, end, inTitle) ||
+       !read_quoted(pos, end, inTemplatePath))
+        return 0;
+    page.pageExt = pageExt;
+    read_ext_overrides(pos, end, page);
+
+    std::string unquotedName = unquote(inName),
+                file;
+    size_t fileStart = unquotedName.find_last_of('/') + 1; //0 if there's no '/'
+
+    file.assign(unquotedName, fileStart, std::string::npos).append(pageExt);
+    if(page.pageExt != pageExt)
+        file = file.substr(0, file.find_first_of('.')) + page.pageExt;
+    pagePath.set_dir(siteDir + unquotedName.substr(0, fileStart));
+    pagePath.set_file(file);
+
+    std::lock_guard<std::mutex> lock(mtx);
+    if(pagePaths.size() >= 1 << 16)
+        pagePaths.clear();
+    pagePaths[key] = pagePath;
+
+    return 1;
+}
+
+//reads the exts line which may follow a page's template path, leaving pos at the start of the next line otherwise
+void read_ext_overrides(const char *&pos, const char *end, PageInfo& page)
+{
+    //skips the rest of the template path line
+    pos = std::find(pos, end, '\n');
+    if(pos == end)
+        return;
+    pos++;
+
+    const char *lineEnd = std::find(pos, end, '\n');
+    if(lineEnd - pos < 5 || std::string(pos, 5) != "exts ")
+        return;
+
+    std::string inExt;
+    pos += 5;
+    if(read_quoted(pos, lineEnd, inExt) && inExt != "-")
+        page.contentExt = inExt;
+    if(read_quoted(pos, lineEnd, inExt) && inExt != "-")
+        page.pageExt = inExt;
+    if(read_quoted(pos, lineEnd, inExt) && inExt != "-")
+        page.scriptExt = inExt;
+    pos = lineEnd;
+}
+
+//reads the name from a page's entry and skips the rest of it, returns 0 if the entry was cut short
+bool read_entry_name(const char *&pos, const char *end, Name& name)
+{
+    std::string inTitle,
+                inTemplatePath;
+    PageInfo page;
+
+    if(!read_quoted(pos, end, name) ||
+       !read_quoted(pos, end, inTitle) ||
+       !read_quoted(pos, end, inTemplatePath))
+        return 0;
+    read_ext_overrides(pos, end, page);
+
+    return 1;
+}
+
+int save_page_index(const std::vector<unsigned long long int>& offsets)
+{
+    std::pair<long long int, long long int> listStamp = file_stamp(".siteinfo/pages.list");
+    unsigned long long int noPages = offsets.size() - 1;
+
+    std::ofstream ofs(".siteinfo/pages.index.tmp", std::ios::binary);
+    ofs.write(pageIndexHeader.c_str(), pageIndexHeader.size());
+    ofs.write((const char*)&listStamp.first, sizeof(listStamp.first));
+    ofs.write((const char*)&listStamp.second, sizeof(listStamp.second));
+    ofs.write((const char*)&noPages, sizeof(noPages));
+    ofs.write((const char*)&offsets[0], offsets.size()*sizeof(offsets[0]));
+    ofs.close();
+
+    #if defined _WIN32 || defined _WIN64
+        std::remove(".siteinfo/pages.index");
+    #endif
+    std::rename(".siteinfo/pages.index.tmp", ".siteinfo/pages.index");
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+#ifndef PAGE_INDEX_H_
+#define PAGE_INDEX_H_
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "FileSystem.h"
+#include "PageInfo.h"
+
+/*
+    finds pages in .siteinfo/pages.list without opening every page, for
+    commands which only need some of them (eg. info). pages.list is saved
+    in order of quoted page name, so pages (and pages whose names start
+    with a prefix) are found by binary searching the offsets of entries.
+    once the journal is read in, pages can be looked up from multiple
+    threads (eg. @pathtopage while building pages in batches)
+*/
+struct PageIndex
+{
+    std::ifstream listIfs,
+                  indexIfs;
+    size_t noPages;
+    std::map<std::string, std::string> journal; //entries changed since pages.list was saved by key, empty once removed
+    std::unordered_map<std::string, Path> pagePaths; //page paths found by key, cleared once large
+    std::mutex mtx;
+
+    //returns 1 if there isn't an index for the current pages.list
+    int open();
+
+    unsigned long long int offset(const size_t& p);
+    //entries p up to (not including) q as they are in pages.list
+    std::string entries(const size_t& p, const size_t& q);
+    //quoted page name of entry p
+    std::string key(const size_t& p);
+    //first entry with a key not less than the given key
+    size_t lower_bound(const std::string& key);
+
+    int read_journal();
+    //entry for the key checking the journal first, returns 0 if the page isn't tracked
+    bool find_entry(const std::string& key, std::string& entry);
+    //page path of a tracked page (same as make_info), returns 0 if the page isn't tracked
+    bool find_page_path(const Name& pageName, const Directory& siteDir, const std::string& pageExt, Path& pagePath);
+};
+
+void read_ext_overrides(const char *&pos, const char *end, PageInfo& page);
+bool read_entry_name(const char *&pos, const char *end, Name& name);
+
+//saves the index for the current pages.list given the offsets of its entries and its size
+int save_page_index(const std::vector<unsigned long long int>& offsets);
+
+#endif //PAGE_INDEX_H_
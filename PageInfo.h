@@ -16,6 +16,9 @@ struct PageInfo
     Path pagePath,
         contentPath,
         templatePath;
+    std::string contentExt, //extensions of the page, either the site's or overridden for the page
+                pageExt,
+                scriptExt;
 };
 
 //output fn
@@ -0,0 +1,345 @@
+#include "PageSet.h"
+
+static const size_t emptySlot = (size_t)-1,
+                    erasedSlot = (size_t)-2;
+
+PageSet::const_iterator::const_iterator()
+{
+    set = NULL;
+    pos = 0;
+}
+
+PageSet::const_iterator::const_iterator(const PageSet* Set, const size_t& Pos)
+{
+    set = Set;
+    pos = Pos;
+}
+
+const PageInfo& PageSet::const_iterator::operator*() const
+{
+    return set->pages[set->order[pos]];
+}
+
+const PageInfo* PageSet::const_iterator::operator->() const
+{
+    return &set->pages[set->order[pos]];
+}
+
+PageSet::const_iterator& PageSet::const_iterator::operator++()
+{
+    pos++;
+    return *this;
+}
+
+PageSet::const_iterator PageSet::const_iterator::operator++(int)
+{
+    const_iterator it = *this;
+    pos++;
+    return it;
+}
+
+PageSet::const_iterator& PageSet::const_iterator::operator--()
+{
+    pos--;
+    return *this;
+}
+
+PageSet::const_iterator PageSet::const_iterator::operator--(int)
+{
+    const_iterator it = *this;
+    pos--;
+    return it;
+}
+
+bool PageSet::const_iterator::operator==(const const_iterator& it) const
+{
+    return (pos == it.pos && set == it.set);
+}
+
+bool PageSet::const_iterator::operator!=(const const_iterator& it) const
+{
+    return (pos != it.pos || set != it.set);
+}
+
+size_t PageSet::const_iterator::id() const
+{
+    return set->order[pos];
+}
+
+PageSet::PageSet()
+{
+    noPages = noUsedSlots = noOrdered = 0;
+    ordered = 1;
+}
+
+PageSet::PageSet(const PageSet& pageSet)
+{
+    *this = pageSet;
+}
+
+PageSet& PageSet::operator=(const PageSet& pageSet)
+{
+    if(this == &pageSet)
+        return *this;
+
+    pageSet.sort_order();
+    pages = pageSet.pages;
+    keys = pageSet.keys;
+    live = pageSet.live;
+    erasedIDs = pageSet.erasedIDs;
+    slots = pageSet.slots;
+    noPages = pageSet.noPages;
+    noUsedSlots = pageSet.noUsedSlots;
+    order = pageSet.order;
+    positions = pageSet.positions;
+    noOrdered = pageSet.noOrdered;
+    ordered = 1;
+
+    return *this;
+}
+
+size_t PageSet::size() const
+{
+    return noPages;
+}
+
+bool PageSet::empty() const
+{
+    return !noPages;
+}
+
+PageSet::const_iterator PageSet::begin() const
+{
+    sort_order();
+    return const_iterator(this, 0);
+}
+
+PageSet::const_iterator PageSet::end() const
+{
+    sort_order();
+    return const_iterator(this, order.size());
+}
+
+PageSet::const_iterator PageSet::find(const PageInfo& page) const
+{
+    size_t id = find_id(quote(page.pageName));
+
+    sort_order();
+    if(id == emptySlot)
+        return const_iterator(this, order.size());
+
+    return const_iterator(this, positions[id]);
+}
+
+size_t PageSet::count(const PageInfo& page) const
+{
+    return (find_id(quote(page.pageName)) != emptySlot);
+}
+
+const PageInfo& PageSet::page(const size_t& id) const
+{
+    return pages[id];
+}
+
+std::pair<size_t, bool> PageSet::insert(const PageInfo& page)
+{
+    std::string key = quote(page.pageName);
+    size_t id = find_id(key);
+
+    if(id != emptySlot)
+        return std::make_pair(id, false);
+
+    //ids of erased pages can only be reused once they've been dropped from the ordered index
+    if(ordered && erasedIDs.size())
+    {
+        id = erasedIDs.back();
+        erasedIDs.pop_back();
+        pages[id] = page;
+        keys[id].swap(key);
+        live[id] = 1;
+    }
+    else
+    {
+        id = pages.size();
+        pages.push_back(page);
+        keys.push_back(key);
+        live.push_back(1);
+        positions.push_back(0);
+    }
+    add_slot(id);
+    noPages++;
+
+    //pages added in order are added to the ordered index straight away
+    if(ordered && (!order.size() || keys[order.back()] < keys[id]))
+    {
+        positions[id] = order.size();
+        order.push_back(id);
+        noOrdered = order.size();
+    }
+    else
+    {
+        order.push_back(id);
+        ordered = 0;
+    }
+
+    return std::make_pair(id, true);
+}
+
+size_t PageSet::update(const PageInfo& page)
+{
+    size_t id = find_id(quote(page.pageName));
+
+    if(id == emptySlot)
+        return insert(page).first;
+
+    pages[id] = page;
+
+    return id;
+}
+
+size_t PageSet::erase(const PageInfo& page)
+{
+    std::string key = quote(page.pageName);
+
+    if(!slots.size())
+        return 0;
+
+    size_t mask = slots.size() - 1;
+    for(size_t s = std::hash<std::string>()(key) & mask; slots[s] != emptySlot; s = (s + 1) & mask)
+    {
+        if(slots[s] != erasedSlot && keys[slots[s]] == key)
+        {
+            size_t id = slots[s];
+
+            slots[s] = erasedSlot;
+            pages[id] = PageInfo();
+            std::string().swap(keys[id]);
+            live[id] = 0;
+            erasedIDs.push_back(id);
+            noPages--;
+
+            //id stays in the ordered index until it is next sorted
+            ordered = 0;
+
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+void PageSet::clear()
+{
+    pages.clear();
+    keys.clear();
+    live.clear();
+    erasedIDs.clear();
+    slots.clear();
+    order.clear();
+    positions.clear();
+    noPages = noUsedSlots = noOrdered = 0;
+    ordered = 1;
+}
+
+void PageSet::swap(PageSet& pageSet)
+{
+    sort_order();
+    pageSet.sort_order();
+
+    pages.swap(pageSet.pages);
+    keys.swap(pageSet.keys);
+    live.swap(pageSet.live);
+    erasedIDs.swap(pageSet.erasedIDs);
+    slots.swap(pageSet.slots);
+    std::swap(noPages, pageSet.noPages);
+    std::swap(noUsedSlots, pageSet.noUsedSlots);
+    order.swap(pageSet.order);
+    positions.swap(pageSet.positions);
+    std::swap(noOrdered, pageSet.noOrdered);
+}
+
+//returns the id of the page with the key (quoted page name), emptySlot if there isn't one
+size_t PageSet::find_id(const std::string& key) const
+{
+    if(!slots.size())
+        return emptySlot;
+
+    size_t mask = slots.size() - 1;
+    for(size_t s = std::hash<std::string>()(key) & mask; slots[s] != emptySlot; s = (s + 1) & mask)
+        if(slots[s] != erasedSlot && keys[slots[s]] == key)
+            return slots[s];
+
+    return emptySlot;
+}
+
+//adds the id to the hash table, which is kept at most half full (including erased slots)
+void PageSet::add_slot(const size_t& id)
+{
+    if(2*(noUsedSlots + 1) > slots.size())
+    {
+        size_t noSlots = 16;
+        while(noSlots < 4*(noPages + 1))
+            noSlots *= 2;
+        rehash(noSlots);
+    }
+
+    size_t mask = slots.size() - 1;
+    size_t s = std::hash<std::string>()(keys[id]) & mask;
+    while(slots[s] != emptySlot && slots[s] != erasedSlot)
+        s = (s + 1) & mask;
+
+    if(slots[s] == emptySlot)
+        noUsedSlots++;
+    slots[s] = id;
+}
+
+void PageSet::rehash(const size_t& noSlots)
+{
+    slots.assign(noSlots, emptySlot);
+    noUsedSlots = 0;
+
+    size_t mask = noSlots - 1;
+    for(size_t id=0; id<pages.size(); id++)
+    {
+        if(!live[id])
+            continue;
+
+        size_t s = std::hash<std::string>()(keys[id]) & mask;
+        while(slots[s] != emptySlot)
+            s = (s + 1) & mask;
+        slots[s] = id;
+        noUsedSlots++;
+    }
+}
+
+//drops erased ids from the ordered index and merges in those added out of order
+void PageSet::sort_order() const
+{
+    if(ordered)
+        return;
+
+    std::lock_guard<std::mutex> lock(mtx);
+
+    if(ordered)
+        return;
+
+    size_t noKept = 0;
+    for(size_t p=0; p<noOrdered; p++)
+        if(live[order[p]])
+            order[noKept++] = order[p];
+    size_t noSorted = noKept;
+    for(size_t p=noOrdered; p<order.size(); p++)
+        if(live[order[p]])
+            order[noKept++] = order[p];
+    order.resize(noKept);
+
+    auto compare = [this](const size_t& id1, const size_t& id2) { return keys[id1] < keys[id2]; };
+    std::sort(order.begin() + noSorted, order.end(), compare);
+    std::inplace_merge(order.begin(), order.begin() + noSorted, order.end(), compare);
+
+    for(size_t p=0; p<order.size(); p++)
+        positions[order[p]] = p;
+    noOrdered = order.size();
+
+    ordered = 1;
+}
@@ -0,0 +1,91 @@
+#ifndef PAGE_SET_H_
+#define PAGE_SET_H_
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
+#include "PageInfo.h"
+
+/*
+    set of pages ordered by quoted page name (same as operator< for
+    PageInfo), kept in a vector indexed by page ids along with their quoted
+    names, so comparisons don't need to quote names again. a page's id
+    doesn't change while it is in the set (ids of removed pages are reused).
+    lookups go through an open addressing hash table of ids, the ordered
+    index of ids is appended to when pages are added in order (eg. reading
+    pages.list) and otherwise sorted and merged the next time the set is
+    iterated over, which is safe to do from multiple threads
+*/
+struct PageSet
+{
+    struct const_iterator
+    {
+        typedef std::bidirectional_iterator_tag iterator_category;
+        typedef PageInfo value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const PageInfo* pointer;
+        typedef const PageInfo& reference;
+
+        const PageSet* set;
+        size_t pos; //position in the ordered index
+
+        const_iterator();
+        const_iterator(const PageSet* Set, const size_t& Pos);
+
+        const PageInfo& operator*() const;
+        const PageInfo* operator->() const;
+        const_iterator& operator++();
+        const_iterator operator++(int);
+        const_iterator& operator--();
+        const_iterator operator--(int);
+        bool operator==(const const_iterator& it) const;
+        bool operator!=(const const_iterator& it) const;
+
+        size_t id() const;
+    };
+    typedef const_iterator iterator;
+
+    std::vector<PageInfo> pages; //indexed by page id
+    std::vector<std::string> keys; //quoted page names, same ids as pages
+    std::vector<char> live; //whether each id is in use
+    std::vector<size_t> erasedIDs; //reused once they're out of the ordered index
+    std::vector<size_t> slots; //hash table of ids, size is a power of 2
+    size_t noPages,
+           noUsedSlots;
+    mutable std::vector<size_t> order; //ids sorted by key, then any added out of order
+    mutable std::vector<size_t> positions; //position of each id in order
+    mutable size_t noOrdered;
+    mutable std::atomic<bool> ordered;
+    mutable std::mutex mtx;
+
+    PageSet();
+    PageSet(const PageSet& pageSet);
+    PageSet& operator=(const PageSet& pageSet);
+
+    size_t size() const;
+    bool empty() const;
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator find(const PageInfo& page) const;
+    size_t count(const PageInfo& page) const;
+    const PageInfo& page(const size_t& id) const;
+
+    //adds the page if its name isn't already in the set, returns its id and whether it was added
+    std::pair<size_t, bool> insert(const PageInfo& page);
+    //adds the page or replaces the page with the same name, which keeps its id
+    size_t update(const PageInfo& page);
+    size_t erase(const PageInfo& page);
+    void clear();
+    void swap(PageSet& pageSet);
+
+    size_t find_id(const std::string& key) const;
+    void add_slot(const size_t& id);
+    void rehash(const size_t& noSlots);
+    void sort_order() const;
+};
+
+#endif //PAGE_SET_H_
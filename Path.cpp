@@ -2,19 +2,45 @@
 
 Path::Path()
 {
-    type = "none";
+    dirID = fileID = 0;
 }
 
 Path::Path(const Directory &Dir, const Filename &File)
 {
-    dir = Dir;
-    file = File;
-    type = "file";
+    dirID = stringPool.intern(Dir);
+    fileID = stringPool.intern(File);
+}
+
+Directory Path::dir() const
+{
+    return stringPool.str(dirID);
+}
+
+Filename Path::file() const
+{
+    return stringPool.str(fileID);
+}
+
+void Path::set_dir(const Directory &Dir)
+{
+    dirID = stringPool.intern(Dir);
+}
+
+void Path::set_file(const Filename &File)
+{
+    fileID = stringPool.intern(File);
 }
 
 std::string Path::str() const
 {
-    return dir + file;
+    const StringPool::Entry &dirEntry = stringPool.entry(dirID),
+                            &fileEntry = stringPool.entry(fileID);
+    std::string pathStr;
+
+    pathStr.reserve(dirEntry.size + fileEntry.size);
+    pathStr.append(dirEntry.str, dirEntry.size).append(fileEntry.str, fileEntry.size);
+
+    return pathStr;
     //return quote(dir + file);
     /*
         consider:  <a href=@pathtofile('site/pdfs/Example name.pdf')>pdf</a>
@@ -25,7 +51,70 @@ std::string Path::str() const
 //removes ./ from the front if it's there
 std::string Path::comparableStr() const
 {
-    return comparable(dir) + file;
+    const char* strs[2];
+    size_t sizes[2];
+    comparable_pieces(strs, sizes);
+
+    std::string pathStr;
+    pathStr.reserve(sizes[0] + sizes[1]);
+    pathStr.append(strs[0], sizes[0]).append(strs[1], sizes[1]);
+
+    return pathStr;
+}
+
+//the comparable form is the directory without any leading ./ followed by the filename, as kept in stringPool
+void Path::comparable_pieces(const char* strs[2], size_t sizes[2]) const
+{
+    const StringPool::Entry &dirEntry = stringPool.entry(dirID),
+                            &fileEntry = stringPool.entry(fileID);
+
+    strs[0] = dirEntry.str;
+    sizes[0] = dirEntry.size;
+    if(sizes[0] > 1 && strs[0][0] == '.' && strs[0][1] == '/')
+    {
+        strs[0] += 2;
+        sizes[0] -= 2;
+    }
+    strs[1] = fileEntry.str;
+    sizes[1] = fileEntry.size;
+}
+
+//compares the comparable forms of two paths a piece at a time rather than putting them together
+int compare(const Path &path1, const Path &path2)
+{
+    if(path1.dirID == path2.dirID && path1.fileID == path2.fileID)
+        return 0;
+
+    const char *strs1[2], *strs2[2];
+    size_t sizes1[2], sizes2[2];
+    path1.comparable_pieces(strs1, sizes1);
+    path2.comparable_pieces(strs2, sizes2);
+
+    int p1 = 0, p2 = 0;
+    size_t pos1 = 0, pos2 = 0;
+    while(1)
+    {
+        while(p1 < 2 && pos1 == sizes1[p1])
+        {
+            p1++;
+            pos1 = 0;
+        }
+        while(p2 < 2 && pos2 == sizes2[p2])
+        {
+            p2++;
+            pos2 = 0;
+        }
+
+        if(p1 == 2 || p2 == 2)
+            return (p1 == 2) ? (p2 == 2 ? 0 : -1) : 1;
+
+        size_t n = std::min(sizes1[p1] - pos1, sizes2[p2] - pos2);
+        int cmp = std::memcmp(strs1[p1] + pos1, strs2[p2] + pos2, n);
+        if(cmp)
+            return cmp;
+        pos1 += n;
+        pos2 += n;
+    }
 }
 
 //outputs path (quoted if it contains spaces)
@@ -40,10 +129,15 @@ void Path::set_file_path_from(const std::string &s)
 {
     size_t pos = s.find_last_of('/');
     if(pos == std::string::npos)
-        *this = Path("", s);
+    {
+        dirID = 0;
+        fileID = stringPool.intern(s);
+    }
     else
-        *this = Path(s.substr(0, (pos+1)),
-                     s.substr(pos+1, s.size()-(pos+1)) );
+    {
+        dirID = stringPool.intern(s.c_str(), pos+1);
+        fileID = stringPool.intern(s.c_str() + pos+1, s.size()-(pos+1));
+    }
 }
 
 std::istream& Path::read_file_path_from(std::istream &is)
@@ -62,15 +156,21 @@ bool Path::modified_after(const Path &path2) const
     stat(str().c_str(), &sb1);
     stat(path2.str().c_str(), &sb2);
 
-    if(difftime(sb1.st_mtime, sb2.st_mtime) > 0)
-        return 1;
-    else
-        return 0;
+    //compares nanoseconds where available, so changes within the same second aren't missed
+    #if defined _WIN32 || defined _WIN64
+        return difftime(sb1.st_mtime, sb2.st_mtime) > 0;
+    #elif defined __APPLE__
+        return sb1.st_mtimespec.tv_sec > sb2.st_mtimespec.tv_sec ||
+               (sb1.st_mtimespec.tv_sec == sb2.st_mtimespec.tv_sec && sb1.st_mtimespec.tv_nsec > sb2.st_mtimespec.tv_nsec);
+    #else  //unix
+        return sb1.st_mtim.tv_sec > sb2.st_mtim.tv_sec ||
+               (sb1.st_mtim.tv_sec == sb2.st_mtim.tv_sec && sb1.st_mtim.tv_nsec > sb2.st_mtim.tv_nsec);
+    #endif
 }
 
 Path Path::getInfoPath() const
 {
-    return Path(".siteinfo/" + dir,  strippedExtension(file) + ".info");
+    return Path(".siteinfo/" + dir(),  strippedExtension(file()) + ".info");
 }
 
 bool Path::removePath() const
@@ -82,7 +182,7 @@ bool Path::removePath() const
 
 bool Path::ensurePathExists() const
 {
-    std::deque<Directory> dDeque = dirDeque(dir);
+    std::deque<Directory> dDeque = dirDeque(dir());
     std::string cDir="";
 
     for(size_t d=0; d<dDeque.size(); d++)
@@ -96,7 +196,7 @@ bool Path::ensurePathExists() const
         #endif
     }
 
-    if(file.length())
+    if(fileID)
     {
         close(creat(str().c_str(), O_CREAT));
     }
@@ -107,18 +207,28 @@ bool Path::ensurePathExists() const
 //equality relation
 bool operator==(const Path &path1, const Path &path2)
 {
-    return (path1.comparableStr() == path2.comparableStr());
+    return !compare(path1, path2);
 }
 
 //inequality relation
 bool operator!=(const Path &path1, const Path &path2)
 {
-    return (path1.comparableStr() != path2.comparableStr());
+    return compare(path1, path2) != 0;
 }
 
 //less than relation
 bool operator<(const Path &path1, const Path &path2)
 {
-    return (path1.comparableStr() < path2.comparableStr());
+    return compare(path1, path2) < 0;
+}
+
+//hashes the comparable form a piece at a time, which hashes the same as the whole
+size_t std::hash<Path>::operator()(const Path &path) const
+{
+    const char* strs[2];
+    size_t sizes[2];
+    path.comparable_pieces(strs, sizes);
+
+    return fnv1a(strs[1], sizes[1], fnv1a(strs[0], sizes[0]));
 }
 
@@ -1,6 +1,8 @@
 #ifndef PATH_H_
 #define PATH_H_
 
+#include <algorithm>
+#include <functional>
 #include <vector>
 
 #include <sys/types.h>
@@ -15,21 +17,28 @@
 
 #include "Directory.h"
 #include "Filename.h"
+#include "StringPool.h"
 
+//directory and filename are interned in stringPool, so paths are just a pair of ids
 struct Path
 {
-    Directory dir;
-    Filename file;
-    std::string type;
+    StringID dirID,
+             fileID;
 
     Path();
     Path(const Directory &Dir, const Filename &File);
 
+    Directory dir() const;
+    Filename file() const;
+    void set_dir(const Directory &Dir);
+    void set_file(const Filename &File);
+
     void set_file_path_from(const std::string &s);
     std::istream& read_file_path_from(std::istream &is);
 
     std::string str() const;
     std::string comparableStr() const;
+    void comparable_pieces(const char* strs[2], size_t sizes[2]) const;
 
     //returns whether first file was modified after second file
     bool modified_after(const Path &path2) const;
@@ -49,5 +58,16 @@ bool operator==(const Path &path1, const Path &path2);
 bool operator!=(const Path &path1, const Path &path2);
 //less than relation
 bool operator<(const Path &path1, const Path &path2);
+//compares paths without allocating, negative/zero/positive like strcmp
+int compare(const Path &path1, const Path &path2);
+
+//so paths can be used in unordered containers
+namespace std
+{
+    template <> struct hash<Path>
+    {
+        size_t operator()(const Path &path) const;
+    };
+}
 
 #endif //PATH_H_
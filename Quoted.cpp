@@ -35,6 +35,55 @@ bool read_quoted(std::istream &ifs, std::string &s)
     return 1;
 }
 
+bool read_quoted(const char *&pos, const char *end, std::string &s)
+{
+    while(pos < end && std::isspace((unsigned char)*pos))
+        pos++;
+    if(pos == end)
+        return 0;
+
+    //reads first word
+    const char *word = pos;
+    while(pos < end && !std::isspace((unsigned char)*pos))
+        pos++;
+
+    char q = *word;
+    if(q != '"' && q != '\'')
+    {
+        s.assign(word, pos);
+        return 1;
+    }
+    else if(pos - word > 1 && pos[-1] == q)
+    {
+        s.assign(word + 1, pos - 1);
+        return 1;
+    }
+
+    //reads words until one ends with the quote, joined by single spaces
+    s.assign(word + 1, pos);
+    while(pos < end)
+    {
+        while(pos < end && std::isspace((unsigned char)*pos))
+            pos++;
+        if(pos == end)
+            break;
+
+        word = pos;
+        while(pos < end && !std::isspace((unsigned char)*pos))
+            pos++;
+
+        s += ' ';
+        if(pos[-1] == q)
+        {
+            s.append(word, pos - 1);
+            break;
+        }
+        s.append(word, pos);
+    }
+
+    return 1;
+}
+
 //outputting a string with quotes surrounded if it contains space(s)
 std::string quote(const std::string &unquoted)
 {
@@ -1,6 +1,7 @@
 #ifndef QUOTED_H_
 #define QUOTED_H_
 
+#include <cctype>
 #include <cstdio>
 #include <iostream>
 #include <fstream>
@@ -9,6 +10,8 @@
 //reading a string which may be surrounded by quotes with spaces, and strips surrounding quotes
 //note mutates white space into single spaces
 bool read_quoted(std::istream &ifs, std::string &s);
+//reads the same from a buffer, moving pos past what was read (for reading whole files in one go)
+bool read_quoted(const char *&pos, const char *end, std::string &s);
 
 //outputting a string with quotes surrounded if it contains space(s)
 std::string quote(const std::string &unquoted);
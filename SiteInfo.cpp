@@ -21,50 +21,81 @@ int SiteInfo::open_config()
 
     contentDir = siteDir = "";
     buildThreads = 0;
+    autoBuildThreads = 0;
+    parallelInputs = 0;
+    hashDeps = 0;
+    buildState = 0;
+    pagesListVersion = 1;
+    buildTime = "";
+    shardNo = noShards = 1;
+    shardByCost = 0;
+    dryRun = 0;
     contentExt = pageExt = scriptExt = unixTextEditor = winTextEditor = rootBranch = siteBranch = "";
     defaultTemplate = Path("", "");
 
-    //reads Nift config file
-    std::ifstream ifs(".siteinfo/nsm.config");
-    std::string inLine, inType;
-    while(getline(ifs, inLine))
+    //reads Nift config file in one go
+    std::string data, inType, inValue;
+    read_file(".siteinfo/nsm.config", data);
+    const char *lineStart = data.c_str(),
+               *dataEnd = lineStart + data.size(),
+               *lineEnd, *pos;
+    for(; lineStart < dataEnd; lineStart = lineEnd + 1)
     {
-        if(!is_whitespace(inLine) && inLine.size() && inLine[0] != '#')
-        {
-            std::istringstream iss(inLine);
-
-            iss >> inType;
-
-            if(inType == "contentDir")
-                read_quoted(iss, contentDir);
-            else if(inType == "contentExt")
-                read_quoted(iss, contentExt);
-            else if(inType == "siteDir")
-                read_quoted(iss, siteDir);
-            else if(inType == "pageExt")
-                read_quoted(iss, pageExt);
-            else if(inType == "scriptExt")
-                read_quoted(iss, scriptExt);
-            else if(inType == "defaultTemplate")
-                defaultTemplate.read_file_path_from(iss);
-            else if(inType == "buildThreads")
-                iss >> buildThreads;
-            else if(inType == "unixTextEditor")
-                read_quoted(iss, unixTextEditor);
-            else if(inType == "winTextEditor")
-                read_quoted(iss, winTextEditor);
-            else if(inType == "rootBranch")
-                read_quoted(iss, rootBranch);
-            else if(inType == "siteBranch")
-                read_quoted(iss, siteBranch);
-            else
+        lineEnd = std::find(lineStart, dataEnd, '\n');
+        pos = lineStart;
+
+        if(*pos == '#' || !read_quoted(pos, lineEnd, inType))
+            continue;
+
+        inValue = "";
+        read_quoted(pos, lineEnd, inValue);
+
+        if(inType == "contentDir")
+            contentDir = inValue;
+        else if(inType == "contentExt")
+            contentExt = inValue;
+        else if(inType == "siteDir")
+            siteDir = inValue;
+        else if(inType == "pageExt")
+            pageExt = inValue;
+        else if(inType == "scriptExt")
+            scriptExt = inValue;
+        else if(inType == "defaultTemplate")
+            defaultTemplate.set_file_path_from(inValue);
+        else if(inType == "buildThreads")
+        {
+            if(inValue == "auto")
             {
-                std::cout << "error: .siteinfo/nsm.config: do not recognise confirguration parameter " << inType << std::endl;
-                return 1;
+                autoBuildThreads = 1;
+                buildThreads = -1;
             }
+            else
+                buildThreads = std::atoi(inValue.c_str());
+        }
+        else if(inType == "parallelInputs")
+            parallelInputs = std::atoi(inValue.c_str());
+        else if(inType == "hashDeps")
+            hashDeps = std::atoi(inValue.c_str());
+        else if(inType == "buildState")
+            buildState = std::atoi(inValue.c_str());
+        else if(inType == "buildTime")
+            buildTime = inValue;
+        else if(inType == "pagesListVersion")
+            pagesListVersion = std::atoi(inValue.c_str());
+        else if(inType == "unixTextEditor")
+            unixTextEditor = inValue;
+        else if(inType == "winTextEditor")
+            winTextEditor = inValue;
+        else if(inType == "rootBranch")
+            rootBranch = inValue;
+        else if(inType == "siteBranch")
+            siteBranch = inValue;
+        else
+        {
+            std::cout << "error: .siteinfo/nsm.config: do not recognise confirguration parameter " << inType << std::endl;
+            return 1;
         }
     }
-    ifs.close();
 
     if(contentExt == "" || contentExt[0] != '.')
     {
@@ -171,59 +202,117 @@ int SiteInfo::open_config()
     return 0;
 }
 
-int SiteInfo::open_pages()
+/*
+    .siteinfo/pages.list format:
+
+    page-name
+    page-title
+    template-path
+    exts content-ext page-ext script-ext
+
+    ..
+
+    the exts line is only there for pages with extensions which aren't
+    the site's, extensions which are the site's are written as -
+
+    changes made since pages.list was last saved are appended to
+    .siteinfo/pages.journal, which is replayed over pages.list when
+    opening the site:
+
+    + page-name
+    page-title
+    template-path
+    exts content-ext page-ext script-ext
+
+    - page-name
+
+    ..
+
+    + records add or replace a page and - records remove one. once the
+    journal has more records than half the number of pages (plus 256),
+    or when a command changes every page, pages.list is written out to
+    pages.list.tmp, renamed over pages.list and the journal removed.
+    replaying a journal again (eg. if nsm was killed before removing it)
+    leaves the same pages, a record cut short ends the journal
+*/
+
+std::string ext_override(const std::string& ext, const std::string& siteExt)
 {
-    pages.clear();
+    if(ext == siteExt)
+        return "-";
+    return quote(ext);
+}
 
-    if(!std::ifstream(".siteinfo/pages.list"))
+//reads the extension files pages had beside their info files before they were kept in pages.list
+void read_ext_files(PageInfo& page, std::vector<Path>& extPaths)
+{
+    const char* extTypes[] = {".contExt", ".pageExt", ".scriptExt"};
+    std::string* exts[] = {&page.contentExt, &page.pageExt, &page.scriptExt};
+
+    for(int t=0; t<3; t++)
     {
-        //this should never happen!
-        std::cout << "error: SiteInfo.cpp: open(): could not open site information as '" << get_pwd() << "/.siteinfo/pages.list' does not exist" << std::endl;
-        return 1;
+        Path extPath = page.pagePath.getInfoPath();
+        extPath.set_file(extPath.file().substr(0, extPath.file().find_first_of('.')) + extTypes[t]);
+
+        std::ifstream ifs(extPath.str());
+        if(ifs)
+        {
+            getline(ifs, *exts[t]);
+            extPaths.push_back(extPath);
+        }
     }
+}
 
-    //reads page list file
-    std::ifstream ifs(".siteinfo/pages.list");
+//reads a page's entry from pages.list or its journal, returns 0 if the entry was cut short
+bool SiteInfo::read_page_entry(const char *&pos, const char *end, PageInfo& page, std::vector<Path>* extPaths)
+{
     Name inName;
     Title inTitle;
-    Path inTemplatePath;
-    std::ifstream ifsx;
-    std::string inExt;
-    while(read_quoted(ifs, inName))
-    {
-        inTitle.read_quoted_from(ifs);
-        inTemplatePath.read_file_path_from(ifs);
-
-        PageInfo inPage = make_info(inName, inTitle, inTemplatePath);
+    std::string inTemplatePath;
+    Path templatePath;
 
-        //checks for non-default content extension
-        Path extPath = inPage.pagePath.getInfoPath();
-        extPath.file = extPath.file.substr(0, extPath.file.find_first_of('.')) + ".contExt";
-
-        if(std::ifstream(extPath.str()))
-        {
-            ifsx.open(extPath.str());
+    if(!read_quoted(pos, end, inName) ||
+       !read_quoted(pos, end, inTitle.str) ||
+       !read_quoted(pos, end, inTemplatePath))
+        return 0;
+    templatePath.set_file_path_from(inTemplatePath);
 
-            ifsx >> inExt;
-            inPage.contentPath.file = inPage.contentPath.file.substr(0, inPage.contentPath.file.find_first_of('.')) + inExt;
+    page = make_info(inName, inTitle, templatePath);
 
-            ifsx.close();
-        }
+    //checks for non-default extensions
+    read_ext_overrides(pos, end, page);
+    if(extPaths)
+        read_ext_files(page, *extPaths);
 
-        //checks for non-default page extension
-        extPath = inPage.pagePath.getInfoPath();
-        extPath.file = extPath.file.substr(0, extPath.file.find_first_of('.')) + ".pageExt";
+    if(page.contentExt != contentExt)
+        page.contentPath.set_file(page.contentPath.file().substr(0, page.contentPath.file().find_first_of('.')) + page.contentExt);
+    if(page.pageExt != pageExt)
+        page.pagePath.set_file(page.pagePath.file().substr(0, page.pagePath.file().find_first_of('.')) + page.pageExt);
 
-        if(std::ifstream(extPath.str()))
-        {
-            ifsx.open(extPath.str());
+    return 1;
+}
 
-            ifsx >> inExt;
-            inPage.pagePath.file = inPage.pagePath.file.substr(0, inPage.pagePath.file.find_first_of('.')) + inExt;
+int SiteInfo::open_pages()
+{
+    pages.clear();
 
-            ifsx.close();
-        }
+    if(!std::ifstream(".siteinfo/pages.list"))
+    {
+        //this should never happen!
+        std::cout << "error: SiteInfo.cpp: open(): could not open site information as '" << get_pwd() << "/.siteinfo/pages.list' does not exist" << std::endl;
+        return 1;
+    }
 
+    //reads page list file in one go
+    std::string data;
+    read_file(".siteinfo/pages.list", data);
+    const char *pos = data.c_str(),
+               *end = pos + data.size();
+    PageInfo inPage;
+    bool migrateExts = (pagesListVersion < 2);
+    std::vector<Path> extPaths;
+    while(read_page_entry(pos, end, inPage, migrateExts ? &extPaths : NULL))
+    {
         //checks that content and template files aren't the same
         if(inPage.contentPath == inPage.templatePath)
         {
@@ -233,10 +322,11 @@ int SiteInfo::open_pages()
             return 1;
         }
 
-        //makes sure there's no duplicate entries in pages.list
-        if(pages.count(inPage) > 0)
+        //pages.list is saved in order so pages are inserted at the end, which also checks for duplicate entries
+        auto cPage = pages.insert(inPage);
+        if(!cPage.second)
         {
-            PageInfo cInfo = *(pages.find(inPage));
+            PageInfo cInfo = pages.page(cPage.first);
 
             std::cout << "error: failed to open .siteinfo/pages.list" << std::endl;
             std::cout << "reason: duplicate entry for " << inPage.pagePath << std::endl;
@@ -257,11 +347,239 @@ int SiteInfo::open_pages()
 
             return 1;
         }
+    }
 
-        pages.insert(inPage);
+    //replays changes made since pages.list was last saved
+    noJournalRecords = 0;
+    if(!read_file(".siteinfo/pages.journal", data))
+    {
+        std::string inType;
+        pos = data.c_str();
+        end = pos + data.size();
+        while(read_quoted(pos, end, inType))
+        {
+            if(inType == "+" && read_page_entry(pos, end, inPage, NULL))
+            {
+                pages.update(inPage);
+            }
+            else if(inType == "-" && read_quoted(pos, end, inPage.pageName))
+                pages.erase(inPage);
+            else
+                break;
+
+            noJournalRecords++;
+        }
     }
 
-    ifs.close();
+    //moves extension overrides from the files beside info files in to pages.list
+    if(migrateExts)
+    {
+        save_pages();
+        pagesListVersion = 2;
+        save_config();
+
+        for(size_t e=0; e<extPaths.size(); e++)
+        {
+            chmod(extPaths[e].str().c_str(), 0666);
+            extPaths[e].removePath();
+        }
+
+        if(extPaths.size())
+            std::cout << "moved " << extPaths.size() << " page extension files in to .siteinfo/pages.list" << std::endl;
+    }
+
+    return 0;
+}
+
+//indexes pages.list (eg. after it was edited by hand), returns 1 if it can't be indexed as it isn't in order
+int SiteInfo::index_pages()
+{
+    std::string data;
+    if(read_file(".siteinfo/pages.list", data))
+        return 1;
+
+    const char *start = data.c_str(),
+               *pos = start,
+               *end = start + data.size(),
+               *entry;
+    std::vector<unsigned long long int> offsets;
+    Name inName;
+    std::string key,
+                prevKey;
+    while(1)
+    {
+        while(pos < end && std::isspace((unsigned char)*pos))
+            pos++;
+        entry = pos;
+        if(!read_entry_name(pos, end, inName))
+            break;
+
+        key = quote(inName);
+        if(offsets.size() && !(prevKey < key))
+            return 1;
+        offsets.push_back(entry - start);
+        prevKey.swap(key);
+    }
+    offsets.push_back(data.size());
+
+    return save_page_index(offsets);
+}
+
+//opens just the named pages (those which are tracked) using pages.index, for commands like info which don't need every page
+int SiteInfo::open_pages(const std::vector<Name>& pageNames)
+{
+    PageIndex pageIndex;
+    if(pagesListVersion < 2 || (pageIndex.open() && (index_pages() || pageIndex.open())))
+        return open_pages();
+
+    pages.clear();
+
+    std::set<std::string> keys;
+    std::string key,
+                entry;
+    const char *pos, *end;
+    PageInfo inPage;
+    for(size_t n=0; n<pageNames.size(); n++)
+    {
+        key = quote(pageNames[n]);
+        keys.insert(key);
+
+        size_t p = pageIndex.lower_bound(key);
+        if(p < pageIndex.noPages && pageIndex.key(p) == key)
+        {
+            entry = pageIndex.entries(p, p+1);
+            pos = entry.c_str();
+            end = pos + entry.size();
+            if(read_page_entry(pos, end, inPage, NULL))
+                pages.insert(inPage);
+        }
+    }
+
+    //replays changes to the named pages made since pages.list was last saved
+    noJournalRecords = 0;
+    std::string data;
+    if(!read_file(".siteinfo/pages.journal", data))
+    {
+        std::string inType;
+        Name inName;
+        const char *record;
+        pos = data.c_str();
+        end = pos + data.size();
+        while(read_quoted(pos, end, inType))
+        {
+            record = pos;
+            if(inType == "+" && read_entry_name(pos, end, inName))
+            {
+                if(keys.count(quote(inName)))
+                {
+                    pos = record;
+                    read_page_entry(pos, end, inPage, NULL);
+                    pages.update(inPage);
+                }
+            }
+            else if(inType == "-" && read_quoted(pos, end, inPage.pageName))
+            {
+                if(keys.count(quote(inPage.pageName)))
+                    pages.erase(inPage);
+            }
+            else
+                break;
+
+            noJournalRecords++;
+        }
+    }
+
+    return 0;
+}
+
+//reads the names of tracked pages starting with prefix, in order, using pages.index rather than opening every page
+int SiteInfo::read_page_names(const std::string& prefix, std::vector<Name>& pageNames)
+{
+    pageNames.clear();
+
+    PageIndex pageIndex;
+    if(pagesListVersion < 2 || (pageIndex.open() && (index_pages() || pageIndex.open())))
+    {
+        if(open_pages())
+            return 1;
+
+        for(auto page=pages.begin(); page!=pages.end(); page++)
+            if(!page->pageName.compare(0, prefix.size(), prefix))
+                pageNames.push_back(page->pageName);
+
+        return 0;
+    }
+
+    //the last change in the journal to each page, by quoted name
+    std::map<std::string, std::pair<Name, bool> > changes;
+    std::string data,
+                inType;
+    Name inName;
+    const char *pos, *end;
+    if(!read_file(".siteinfo/pages.journal", data))
+    {
+        pos = data.c_str();
+        end = pos + data.size();
+        while(read_quoted(pos, end, inType))
+        {
+            if(inType == "+" && read_entry_name(pos, end, inName))
+                changes[quote(inName)] = std::make_pair(inName, 1);
+            else if(inType == "-" && read_quoted(pos, end, inName))
+                changes[quote(inName)] = std::make_pair(inName, 0);
+            else
+                break;
+        }
+    }
+
+    //names starting with prefix are quoted as prefix.. (just letters and digits) or with a quote before prefix,
+    //scanned in order skipping any range inside a range already scanned
+    std::vector<std::string> keyPrefixes;
+    keyPrefixes.push_back(prefix);
+    if(prefix.size())
+    {
+        keyPrefixes.push_back("'" + prefix);
+        keyPrefixes.push_back("\"" + prefix);
+    }
+    std::sort(keyPrefixes.begin(), keyPrefixes.end());
+
+    std::vector<std::pair<std::string, Name> > found;
+    std::string key,
+                entries;
+    const size_t batchSize = 4096;
+    for(size_t k=0; k<keyPrefixes.size(); k++)
+    {
+        if(k && !keyPrefixes[k].compare(0, keyPrefixes[k-1].size(), keyPrefixes[k-1]))
+            continue;
+
+        bool inRange = 1;
+        for(size_t p=pageIndex.lower_bound(keyPrefixes[k]); inRange && p<pageIndex.noPages; p+=batchSize)
+        {
+            entries = pageIndex.entries(p, std::min(p + batchSize, pageIndex.noPages));
+            pos = entries.c_str();
+            end = pos + entries.size();
+            while(read_entry_name(pos, end, inName))
+            {
+                key = quote(inName);
+                if(key.compare(0, keyPrefixes[k].size(), keyPrefixes[k]))
+                {
+                    inRange = 0;
+                    break;
+                }
+                if(!inName.compare(0, prefix.size(), prefix) && !changes.count(key))
+                    found.push_back(std::make_pair(key, inName));
+            }
+        }
+    }
+
+    //merges in pages added by the journal
+    size_t noListed = found.size();
+    for(auto change=changes.begin(); change!=changes.end(); change++)
+        if(change->second.second && !change->second.first.compare(0, prefix.size(), prefix))
+            found.push_back(std::make_pair(change->first, change->second.first));
+    std::inplace_merge(found.begin(), found.begin() + noListed, found.end());
+
+    for(size_t f=0; f<found.size(); f++)
+        pageNames.push_back(found[f].second);
 
     return 0;
 }
@@ -275,7 +593,20 @@ int SiteInfo::save_config()
     ofs << "pageExt " << quote(pageExt) << "\n";
     ofs << "scriptExt " << quote(scriptExt) << "\n";
     ofs << "defaultTemplate " << defaultTemplate << "\n\n";
-    ofs << "buildThreads " << buildThreads << "\n\n";
+    if(autoBuildThreads)
+        ofs << "buildThreads auto\n\n";
+    else
+        ofs << "buildThreads " << buildThreads << "\n\n";
+    if(parallelInputs)
+        ofs << "parallelInputs " << parallelInputs << "\n\n";
+    if(hashDeps)
+        ofs << "hashDeps 1\n\n";
+    if(buildState)
+        ofs << "buildState 1\n\n";
+    if(buildTime != "")
+        ofs << "buildTime " << buildTime << "\n\n";
+    if(pagesListVersion > 1)
+        ofs << "pagesListVersion " << pagesListVersion << "\n\n";
     ofs << "unixTextEditor " << quote(unixTextEditor) << "\n";
     ofs << "winTextEditor " << quote(winTextEditor) << "\n\n";
     ofs << "rootBranch " << quote(rootBranch) << "\n";
@@ -285,52 +616,97 @@ int SiteInfo::save_config()
     return 0;
 }
 
-int SiteInfo::save_pages()
+//values of the config keys pages can read when built (eg. with @sitedir)
+int SiteInfo::get_config_values(std::map<std::string, std::string>& configValues)
 {
-    std::ofstream ofs(".siteinfo/pages.list");
+    configValues.clear();
+    configValues["contentDir"] = contentDir;
+    configValues["contentExt"] = contentExt;
+    configValues["siteDir"] = siteDir;
+    configValues["pageExt"] = pageExt;
+    configValues["scriptExt"] = scriptExt;
+    configValues["defaultTemplate"] = defaultTemplate.str();
 
-    for(auto page=pages.begin(); page!=pages.end(); page++)
-        ofs << *page << "\n\n";
+    return 0;
+}
 
-    ofs.close();
+std::ostream& SiteInfo::write_page_entry(std::ostream& os, const PageInfo& page)
+{
+    os << page << "\n";
+    if(page.contentExt != contentExt || page.pageExt != pageExt || page.scriptExt != scriptExt)
+    {
+        os << "exts " << ext_override(page.contentExt, contentExt) << " " << ext_override(page.pageExt, pageExt);
+        os << " " << ext_override(page.scriptExt, scriptExt) << "\n";
+    }
 
-    return 0;
+    return os;
 }
 
-PageInfo SiteInfo::make_info(const Name &pageName)
+int SiteInfo::save_pages()
 {
-    PageInfo pageInfo;
+    //records where each page's entry starts for pages.index
+    std::ostringstream oss;
+    std::vector<unsigned long long int> offsets;
+    for(auto page=pages.begin(); page!=pages.end(); page++)
+    {
+        offsets.push_back(oss.tellp());
+        write_page_entry(oss, *page) << "\n";
+    }
 
-    pageInfo.pageName = pageName;
+    std::string data = oss.str();
+    offsets.push_back(data.size());
 
-    Path pageNameAsPath;
-    pageNameAsPath.set_file_path_from(unquote(pageName));
+    std::ofstream ofs(".siteinfo/pages.list.tmp", std::ios::binary);
+    ofs.write(data.c_str(), data.size());
+    ofs.close();
 
-    pageInfo.contentPath = Path(contentDir + pageNameAsPath.dir, pageNameAsPath.file + contentExt);
-    pageInfo.pagePath = Path(siteDir + pageNameAsPath.dir, pageNameAsPath.file + pageExt);
+    //replaces pages.list in one go so it's never left half written
+    #if defined _WIN32 || defined _WIN64
+        std::remove(".siteinfo/pages.list");
+    #endif
+    std::rename(".siteinfo/pages.list.tmp", ".siteinfo/pages.list");
+    save_page_index(offsets);
 
-    pageInfo.pageTitle = pageName;
-    pageInfo.templatePath = defaultTemplate;
+    //the journal's changes are now in pages.list
+    std::remove(".siteinfo/pages.journal");
+    noJournalRecords = 0;
 
-    return pageInfo;
+    return 0;
 }
 
-PageInfo SiteInfo::make_info(const Name &pageName, const Title &pageTitle)
+//appends changes to pages in the set of pages to the pages.list journal rather than rewriting pages.list
+int SiteInfo::save_page_changes(const std::vector<Name>& removedNames, const std::vector<PageInfo>& updatedPages)
 {
-    PageInfo pageInfo;
-
-    pageInfo.pageName = pageName;
+    noJournalRecords += removedNames.size() + updatedPages.size();
+    //compacts once the journal is more than half the size of the set of pages
+    if(noJournalRecords > pages.size()/2 + 256)
+        return save_pages();
+
+    std::ostringstream oss;
+    for(size_t p=0; p<removedNames.size(); p++)
+        oss << "- " << quote(removedNames[p]) << "\n\n";
+    for(size_t p=0; p<updatedPages.size(); p++)
+        write_page_entry(oss << "+ ", updatedPages[p]) << "\n";
+
+    std::string records = oss.str();
+    std::ofstream ofs(".siteinfo/pages.journal", std::ios::app);
+    ofs.write(records.c_str(), records.size());
+    ofs.close();
 
-    Path pageNameAsPath;
-    pageNameAsPath.set_file_path_from(unquote(pageName));
+    return 0;
+}
 
-    pageInfo.contentPath = Path(contentDir + pageNameAsPath.dir, pageNameAsPath.file + contentExt);
-    pageInfo.pagePath = Path(siteDir + pageNameAsPath.dir, pageNameAsPath.file + pageExt);
+PageInfo SiteInfo::make_info(const Name &pageName)
+{
+    Title pageTitle;
+    pageTitle = pageName;
 
-    pageInfo.pageTitle = pageTitle;
-    pageInfo.templatePath = defaultTemplate;
+    return make_info(pageName, pageTitle, defaultTemplate);
+}
 
-    return pageInfo;
+PageInfo SiteInfo::make_info(const Name &pageName, const Title &pageTitle)
+{
+    return make_info(pageName, pageTitle, defaultTemplate);
 }
 
 PageInfo SiteInfo::make_info(const Name &pageName, const Title &pageTitle, const Path &templatePath)
@@ -339,11 +715,25 @@ PageInfo SiteInfo::make_info(const Name &pageName, const Title &pageTitle, const
 
     pageInfo.pageName = pageName;
 
-    Path pageNameAsPath;
-    pageNameAsPath.set_file_path_from(unquote(pageName));
+    //splits the page name in to directory and file, this is done for every page when opening a site
+    std::string unquotedName = unquote(pageName),
+                pathStr;
+    size_t fileStart = unquotedName.find_last_of('/') + 1; //0 if there's no '/'
 
-    pageInfo.contentPath = Path(contentDir + pageNameAsPath.dir, pageNameAsPath.file + contentExt);
-    pageInfo.pagePath = Path(siteDir + pageNameAsPath.dir, pageNameAsPath.file + pageExt);
+    pathStr.reserve(unquotedName.size() + 64);
+    pathStr.append(contentDir).append(unquotedName, 0, fileStart);
+    pageInfo.contentPath.set_dir(pathStr);
+    pathStr.assign(unquotedName, fileStart, std::string::npos).append(contentExt);
+    pageInfo.contentPath.set_file(pathStr);
+
+    pathStr.assign(siteDir).append(unquotedName, 0, fileStart);
+    pageInfo.pagePath.set_dir(pathStr);
+    pathStr.assign(unquotedName, fileStart, std::string::npos).append(pageExt);
+    pageInfo.pagePath.set_file(pathStr);
+
+    pageInfo.contentExt = contentExt;
+    pageInfo.pageExt = pageExt;
+    pageInfo.scriptExt = scriptExt;
 
     pageInfo.pageTitle = pageTitle;
     pageInfo.templatePath = templatePath;
@@ -360,8 +750,10 @@ PageInfo make_info(const Name &pageName, const Title &pageTitle, const Path &tem
     Path pageNameAsPath;
     pageNameAsPath.set_file_path_from(unquote(pageName));
 
-    pageInfo.contentPath = Path(contentDir + pageNameAsPath.dir, pageNameAsPath.file + contentExt);
-    pageInfo.pagePath = Path(siteDir + pageNameAsPath.dir, pageNameAsPath.file + pageExt);
+    pageInfo.contentPath = Path(contentDir + pageNameAsPath.dir(), pageNameAsPath.file() + contentExt);
+    pageInfo.pagePath = Path(siteDir + pageNameAsPath.dir(), pageNameAsPath.file() + pageExt);
+    pageInfo.contentExt = contentExt;
+    pageInfo.pageExt = pageExt;
 
     pageInfo.pageTitle = pageTitle;
     pageInfo.templatePath = templatePath;
@@ -429,12 +821,16 @@ int SiteInfo::info_all()
     return 0;
 }
 
-int SiteInfo::info_names()
+int SiteInfo::info_names(const std::string& prefix)
 {
+    std::vector<Name> pageNames;
+    if(read_page_names(prefix, pageNames))
+        return 1;
+
     std::cout << std::endl;
     std::cout << "--------- all tracked page names ---------" << std::endl;
-    for(auto page=pages.begin(); page!=pages.end(); page++)
-        std::cout << page->pageName << std::endl;
+    for(size_t p=0; p<pageNames.size(); p++)
+        std::cout << pageNames[p] << std::endl;
     std::cout << "------------------------------------------" << std::endl;
 
     return 0;
@@ -442,26 +838,14 @@ int SiteInfo::info_names()
 
 std::string SiteInfo::get_ext(const PageInfo& page, const std::string& extType)
 {
-    std::string ext;
-
-    //checks for non-default page extension
-    Path extPath = page.pagePath.getInfoPath();
-    extPath.file = extPath.file.substr(0, extPath.file.find_first_of('.')) + extType;
-
-    if(std::ifstream(extPath.str()))
-    {
-        std::ifstream ifs(extPath.str());
-        getline(ifs, ext);
-        ifs.close();
-    }
-    else if(extType == ".contExt")
-        ext = contentExt;
+    if(extType == ".contExt")
+        return page.contentExt;
     else if(extType == ".pageExt")
-        ext = pageExt;
+        return page.pageExt;
     else if(extType == ".scriptExt")
-        ext = scriptExt;
+        return page.scriptExt;
 
-    return ext;
+    return "";
 }
 
 std::string SiteInfo::get_cont_ext(const PageInfo& page)
@@ -491,30 +875,29 @@ bool SiteInfo::tracking(const Name &pageName)
     return pages.count(page);
 }
 
-int SiteInfo::track(const Name &name, const Title &title, const Path &templatePath)
+//checks a page can be tracked, printing why not otherwise
+int SiteInfo::check_track(const PageInfo &newPage)
 {
-    if(name.find('.') != std::string::npos)
+    if(newPage.pageName.find('.') != std::string::npos)
     {
         std::cout << "error: page names cannot contain '.'" << std::endl;
         return 1;
     }
-    else if(name == "" || title.str == "" || templatePath == Path("", ""))
+    else if(newPage.pageName == "" || newPage.pageTitle.str == "" || newPage.templatePath == Path("", ""))
     {
         std::cout << "error: page name, title and template path must all be non-empty strings" << std::endl;
         return 1;
     }
     else if(
-                (unquote(name).find('"') != std::string::npos && unquote(name).find('\'') != std::string::npos) ||
-                (unquote(title.str).find('"') != std::string::npos && unquote(title.str).find('\'') != std::string::npos) ||
-                (unquote(templatePath.str()).find('"') != std::string::npos && unquote(templatePath.str()).find('\'') != std::string::npos)
+                (unquote(newPage.pageName).find('"') != std::string::npos && unquote(newPage.pageName).find('\'') != std::string::npos) ||
+                (unquote(newPage.pageTitle.str).find('"') != std::string::npos && unquote(newPage.pageTitle.str).find('\'') != std::string::npos) ||
+                (unquote(newPage.templatePath.str()).find('"') != std::string::npos && unquote(newPage.templatePath.str()).find('\'') != std::string::npos)
             )
     {
         std::cout << "error: page name, title and template path cannot contain both single and double quotes" << std::endl;
         return 1;
     }
 
-    PageInfo newPage = make_info(name, title, templatePath);
-
     if(newPage.contentPath == newPage.templatePath)
     {
         std::cout << std::endl;
@@ -538,7 +921,12 @@ int SiteInfo::track(const Name &name, const Title &title, const Path &templatePa
         return 1;
     }
 
-    //warns user if content and/or template paths don't exist
+    return 0;
+}
+
+//warns user if content and/or template paths don't exist, creating the content file
+int SiteInfo::check_new_files(const PageInfo &newPage)
+{
     if(!std::ifstream(newPage.contentPath.str()))
     {
         std::cout << std::endl;
@@ -552,14 +940,23 @@ int SiteInfo::track(const Name &name, const Title &title, const Path &templatePa
         std::cout << "warning: template path " << newPage.templatePath << " does not exist" << std::endl;
     }
 
+    return 0;
+}
+
+int SiteInfo::track(const Name &name, const Title &title, const Path &templatePath)
+{
+    PageInfo newPage = make_info(name, title, templatePath);
+
+    if(check_track(newPage))
+        return 1;
+
+    check_new_files(newPage);
+
     //inserts new page into set of pages
     pages.insert(newPage);
 
-    //saves new set of pages to pages.list
-    std::ofstream ofs(".siteinfo/pages.list");
-    for(auto page=pages.begin(); page!=pages.end(); page++)
-        ofs << *page << "\n\n";
-    ofs.close();
+    //adds the change to the pages.list journal
+    save_page_changes(std::vector<Name>(), std::vector<PageInfo>(1, newPage));
 
     //informs user that page addition was successful
     std::cout << std::endl;
@@ -568,6 +965,63 @@ int SiteInfo::track(const Name &name, const Title &title, const Path &templatePa
     return 0;
 }
 
+int SiteInfo::track_many(const std::vector<Name> &names, const std::vector<Title> &titles, const std::vector<Path> &templatePaths)
+{
+    //checks the whole batch before changing anything, checked pages go in to the set of pages so later ones are checked against them
+    std::vector<PageInfo> newPages;
+    for(size_t p=0; p<names.size(); p++)
+    {
+        PageInfo newPage = make_info(names[p], titles[p], templatePaths[p]);
+
+        if(check_track(newPage))
+        {
+            std::cout << "error: failed to track " << quote(names[p]) << ", no pages were tracked" << std::endl;
+            return 1;
+        }
+
+        pages.insert(newPage);
+        newPages.push_back(newPage);
+    }
+
+    for(size_t p=0; p<newPages.size(); p++)
+        check_new_files(newPages[p]);
+
+    //adds the changes to the pages.list journal in one go
+    save_page_changes(std::vector<Name>(), newPages);
+
+    std::cout << std::endl;
+    std::cout << "successfully tracking " << newPages.size() << " new pages" << std::endl;
+
+    return 0;
+}
+
+//removes a page's info file, page file and (optionally) content file, along with their directories if now empty
+int SiteInfo::remove_page_files(const PageInfo &page, const bool &removeContent)
+{
+    //removes page info file and containing dir if now empty
+    chmod(page.pagePath.getInfoPath().str().c_str(), 0666);
+    page.pagePath.getInfoPath().removePath();
+    std::cout << "removed " << page.pagePath.getInfoPath().str() << std::endl;
+    rmdir(page.pagePath.getInfoPath().dir().c_str());
+
+    //removes page file and containing dir if now empty
+    chmod(page.pagePath.str().c_str(), 0666);
+    page.pagePath.removePath();
+    std::cout << "removed " << page.pagePath.str() << std::endl;
+    rmdir(page.pagePath.dir().c_str());
+
+    if(removeContent)
+    {
+        //removes content file and containing dir if now empty
+        chmod(page.contentPath.str().c_str(), 0666);
+        page.contentPath.removePath();
+        std::cout << "removed " << page.contentPath.str() << std::endl;
+        rmdir(page.contentPath.dir().c_str());
+    }
+
+    return 0;
+}
+
 int SiteInfo::untrack(const Name &pageNameToUntrack)
 {
     //checks that page is being tracked
@@ -580,23 +1034,15 @@ int SiteInfo::untrack(const Name &pageNameToUntrack)
 
     PageInfo pageToErase = get_info(pageNameToUntrack);
 
-    //removes page info file and containing dir if now empty
-    chmod(pageToErase.pagePath.getInfoPath().str().c_str(), 0666);
-    pageToErase.pagePath.getInfoPath().removePath();
-    std::cout << "removed " << pageToErase.pagePath.getInfoPath().str() << std::endl;
-    rmdir(pageToErase.pagePath.getInfoPath().dir.c_str());
-
-    //removes page file and containing dir if now empty
-    chmod(pageToErase.pagePath.str().c_str(), 0666);
-    pageToErase.pagePath.removePath();
-    std::cout << "removed " << pageToErase.pagePath.str() << std::endl;
-    rmdir(pageToErase.pagePath.dir.c_str());
+    remove_page_files(pageToErase, 0);
 
     //removes page from pages set
     pages.erase(pageToErase);
+    if(buildState)
+        forget_built_page(pageToErase.pageName, pages);
 
-    //saves new set of pages to pages.list
-    save_pages();
+    //adds the change to the pages.list journal
+    save_page_changes(std::vector<Name>(1, pageToErase.pageName), std::vector<PageInfo>());
 
     //informs user that page was successfully untracked
     std::cout << std::endl;
@@ -617,29 +1063,15 @@ int SiteInfo::rm(const Name &pageNameToRemove)
 
     PageInfo pageToErase = get_info(pageNameToRemove);
 
-    //removes page info file and containing dir if now empty
-    chmod(pageToErase.pagePath.getInfoPath().str().c_str(), 0666);
-    pageToErase.pagePath.getInfoPath().removePath();
-    std::cout << "removed " << pageToErase.pagePath.getInfoPath().str() << std::endl;
-    rmdir(pageToErase.pagePath.getInfoPath().dir.c_str());
-
-    //removes page file and containing dir if now empty
-    chmod(pageToErase.pagePath.str().c_str(), 0666);
-    pageToErase.pagePath.removePath();
-    std::cout << "removed " << pageToErase.pagePath.str() << std::endl;
-    rmdir(pageToErase.pagePath.dir.c_str());
-
-    //removes content file and containing dir if now empty
-    chmod(pageToErase.contentPath.str().c_str(), 0666);
-    pageToErase.contentPath.removePath();
-    std::cout << "removed " << pageToErase.contentPath.str() << std::endl;
-    rmdir(pageToErase.contentPath.dir.c_str());
+    remove_page_files(pageToErase, 1);
 
     //removes page from pages set
     pages.erase(pageToErase);
+    if(buildState)
+        forget_built_page(pageToErase.pageName, pages);
 
-    //saves new set of pages to pages.list
-    save_pages();
+    //adds the change to the pages.list journal
+    save_page_changes(std::vector<Name>(1, pageToErase.pageName), std::vector<PageInfo>());
 
     //informs user that page was successfully removed
     std::cout << std::endl;
@@ -648,14 +1080,62 @@ int SiteInfo::rm(const Name &pageNameToRemove)
     return 0;
 }
 
-int SiteInfo::mv(const Name &oldPageName, const Name &newPageName)
+//untracks (or removes) a batch of pages, nothing is changed unless every page is being tracked
+int SiteInfo::remove_many(const std::vector<Name> &pageNames, const bool &removeContent)
 {
-    if(newPageName.find('.') != std::string::npos)
+    std::vector<PageInfo> pagesToErase;
+    std::vector<Name> erasedNames;
+    std::set<Name> erasedNameSet;
+    for(size_t p=0; p<pageNames.size(); p++)
     {
-        std::cout << "error: new page name cannot contain '.'" << std::endl;
-        return 1;
-    }
-    else if(newPageName == "")
+        //checks that page is being tracked (and not earlier in the batch)
+        if(!tracking(pageNames[p]))
+        {
+            std::cout << std::endl;
+            std::cout << "error: Nift is not tracking " << pageNames[p] << ", no pages were " << (removeContent ? "removed" : "untracked") << std::endl;
+            return 1;
+        }
+
+        pagesToErase.push_back(get_info(pageNames[p]));
+        erasedNames.push_back(pagesToErase.back().pageName);
+        erasedNameSet.insert(pagesToErase.back().pageName);
+        pages.erase(pagesToErase.back());
+    }
+
+    for(size_t p=0; p<pagesToErase.size(); p++)
+        remove_page_files(pagesToErase[p], removeContent);
+
+    if(buildState)
+        forget_built_pages(erasedNameSet, pages);
+
+    //adds the changes to the pages.list journal in one go
+    save_page_changes(erasedNames, std::vector<PageInfo>());
+
+    std::cout << std::endl;
+    std::cout << "successfully " << (removeContent ? "removed " : "untracked ") << erasedNames.size() << " pages" << std::endl;
+
+    return 0;
+}
+
+int SiteInfo::untrack_many(const std::vector<Name> &pageNames)
+{
+    return remove_many(pageNames, 0);
+}
+
+int SiteInfo::rm_many(const std::vector<Name> &pageNames)
+{
+    return remove_many(pageNames, 1);
+}
+
+//checks a tracked page can be moved or copied to a new page name, printing why not otherwise
+int SiteInfo::check_move(const Name &trackedPageName, const Name &newPageName)
+{
+    if(newPageName.find('.') != std::string::npos)
+    {
+        std::cout << "error: new page name cannot contain '.'" << std::endl;
+        return 1;
+    }
+    else if(newPageName == "")
     {
         std::cout << "error: new page name must be a non-empty string" << std::endl;
         return 1;
@@ -665,10 +1145,10 @@ int SiteInfo::mv(const Name &oldPageName, const Name &newPageName)
         std::cout << "error: new page name cannot contain both single and double quotes" << std::endl;
         return 1;
     }
-    else if(!tracking(oldPageName)) //checks old page is being tracked
+    else if(!tracking(trackedPageName)) //checks old page is being tracked
     {
         std::cout << std::endl;
-        std::cout << "error: Nift is not tracking " << oldPageName << std::endl;
+        std::cout << "error: Nift is not tracking " << trackedPageName << std::endl;
         return 1;
     }
     else if(tracking(newPageName)) //checks new page isn't already tracked
@@ -678,20 +1158,31 @@ int SiteInfo::mv(const Name &oldPageName, const Name &newPageName)
         return 1;
     }
 
-    PageInfo oldPageInfo = get_info(oldPageName);
+    return 0;
+}
 
+//info for a page moved or copied from a tracked page, which keeps its template, extensions and (non-default) title
+PageInfo SiteInfo::moved_info(const PageInfo &trackedPageInfo, const Name &newPageName)
+{
     PageInfo newPageInfo;
     newPageInfo.pageName = newPageName;
-    newPageInfo.contentPath.set_file_path_from(contentDir + newPageName + contentExt);
-    newPageInfo.pagePath.set_file_path_from(siteDir + newPageName + pageExt);
-    if(get_title(oldPageInfo.pageName) == oldPageInfo.pageTitle.str)
+    newPageInfo.contentPath.set_file_path_from(contentDir + newPageName + trackedPageInfo.contentExt);
+    newPageInfo.pagePath.set_file_path_from(siteDir + newPageName + trackedPageInfo.pageExt);
+    newPageInfo.contentExt = trackedPageInfo.contentExt;
+    newPageInfo.pageExt = trackedPageInfo.pageExt;
+    newPageInfo.scriptExt = trackedPageInfo.scriptExt;
+    if(get_title(trackedPageInfo.pageName) == trackedPageInfo.pageTitle.str)
         newPageInfo.pageTitle = get_title(newPageName);
     else
-        newPageInfo.pageTitle = oldPageInfo.pageTitle;
-    newPageInfo.templatePath = oldPageInfo.templatePath;
+        newPageInfo.pageTitle = trackedPageInfo.pageTitle;
+    newPageInfo.templatePath = trackedPageInfo.templatePath;
 
-    //moves content file
-    std::ifstream ifs(oldPageInfo.contentPath.str());
+    return newPageInfo;
+}
+
+int SiteInfo::copy_content(const PageInfo &trackedPageInfo, const PageInfo &newPageInfo)
+{
+    std::ifstream ifs(trackedPageInfo.contentPath.str());
     newPageInfo.contentPath.ensurePathExists();
     chmod(newPageInfo.contentPath.str().c_str(), 0666);
     std::ofstream ofs(newPageInfo.contentPath.str());
@@ -701,31 +1192,30 @@ int SiteInfo::mv(const Name &oldPageName, const Name &newPageName)
     ofs.close();
     ifs.close();
 
-    //removes old page info file and containing dir if now empty
-    chmod(oldPageInfo.pagePath.getInfoPath().str().c_str(), 0666);
-    oldPageInfo.pagePath.getInfoPath().removePath();
-    std::cout << "removed " << oldPageInfo.pagePath.getInfoPath().str() << std::endl;
-    rmdir(oldPageInfo.pagePath.getInfoPath().dir.c_str());
+    return 0;
+}
+
+int SiteInfo::mv(const Name &oldPageName, const Name &newPageName)
+{
+    if(check_move(oldPageName, newPageName))
+        return 1;
 
-    //removes old page file and containing dir if now empty
-    chmod(oldPageInfo.pagePath.str().c_str(), 0666);
-    oldPageInfo.pagePath.removePath();
-    std::cout << "removed " << oldPageInfo.pagePath.str() << std::endl;
-    rmdir(oldPageInfo.pagePath.dir.c_str());
+    PageInfo oldPageInfo = get_info(oldPageName);
+    PageInfo newPageInfo = moved_info(oldPageInfo, newPageName);
 
-    //removes old content file and containing dir if now empty
-    chmod(oldPageInfo.contentPath.str().c_str(), 0666);
-    oldPageInfo.contentPath.removePath();
-    std::cout << "removed " << oldPageInfo.contentPath.str() << std::endl;
-    rmdir(oldPageInfo.contentPath.dir.c_str());
+    //moves content file
+    copy_content(oldPageInfo, newPageInfo);
+    remove_page_files(oldPageInfo, 1);
 
     //removes oldPageInfo from pages
     pages.erase(oldPageInfo);
     //adds newPageInfo to pages
     pages.insert(newPageInfo);
+    if(buildState)
+        forget_built_page(oldPageInfo.pageName, pages);
 
-    //saves new set of pages to pages.list
-    save_pages();
+    //adds the changes to the pages.list journal
+    save_page_changes(std::vector<Name>(1, oldPageInfo.pageName), std::vector<PageInfo>(1, newPageInfo));
 
     //informs user that page was successfully moved
     std::cout << std::endl;
@@ -736,62 +1226,20 @@ int SiteInfo::mv(const Name &oldPageName, const Name &newPageName)
 
 int SiteInfo::cp(const Name &trackedPageName, const Name &newPageName)
 {
-    if(newPageName.find('.') != std::string::npos)
-    {
-        std::cout << "error: new page name cannot contain '.'" << std::endl;
-        return 1;
-    }
-    else if(newPageName == "")
-    {
-        std::cout << "error: new page name must be a non-empty string" << std::endl;
-        return 1;
-    }
-    else if(unquote(newPageName).find('"') != std::string::npos && unquote(newPageName).find('\'') != std::string::npos)
-    {
-        std::cout << "error: new page name cannot contain both single and double quotes" << std::endl;
+    if(check_move(trackedPageName, newPageName))
         return 1;
-    }
-    else if(!tracking(trackedPageName)) //checks old page is being tracked
-    {
-        std::cout << std::endl;
-        std::cout << "error: Nift is not tracking " << trackedPageName << std::endl;
-        return 1;
-    }
-    else if(tracking(newPageName)) //checks new page isn't already tracked
-    {
-        std::cout << std::endl;
-        std::cout << "error: Nift is already tracking " << newPageName << std::endl;
-        return 1;
-    }
 
     PageInfo trackedPageInfo = get_info(trackedPageName);
-
-    PageInfo newPageInfo;
-    newPageInfo.pageName = newPageName;
-    newPageInfo.contentPath.set_file_path_from(contentDir + newPageName + contentExt);
-    newPageInfo.pagePath.set_file_path_from(siteDir + newPageName + pageExt);
-    if(get_title(trackedPageInfo.pageName) == trackedPageInfo.pageTitle.str)
-        newPageInfo.pageTitle = get_title(newPageName);
-    else
-        newPageInfo.pageTitle = trackedPageInfo.pageTitle;
-    newPageInfo.templatePath = trackedPageInfo.templatePath;
+    PageInfo newPageInfo = moved_info(trackedPageInfo, newPageName);
 
     //copies content file
-    std::ifstream ifs(trackedPageInfo.contentPath.str());
-    newPageInfo.contentPath.ensurePathExists();
-    chmod(newPageInfo.contentPath.str().c_str(), 0666);
-    std::ofstream ofs(newPageInfo.contentPath.str());
-    std::string inLine;
-    while(getline(ifs, inLine))
-        ofs << inLine << "\n";
-    ofs.close();
-    ifs.close();
+    copy_content(trackedPageInfo, newPageInfo);
 
     //adds newPageInfo to pages
     pages.insert(newPageInfo);
 
-    //saves new set of pages to pages.list
-    save_pages();
+    //adds the change to the pages.list journal
+    save_page_changes(std::vector<Name>(), std::vector<PageInfo>(1, newPageInfo));
 
     //informs user that page was successfully moved
     std::cout << std::endl;
@@ -800,6 +1248,72 @@ int SiteInfo::cp(const Name &trackedPageName, const Name &newPageName)
     return 0;
 }
 
+//moves (or copies) a batch of pages in order, so eg. a to b then b to c works, nothing is changed unless every move can be made
+int SiteInfo::move_many(const std::vector<std::pair<Name, Name> > &moves, const bool &removeTracked)
+{
+    std::vector<PageInfo> trackedPages, newPages;
+    std::set<Name> changedNames, movedNames;
+    for(size_t m=0; m<moves.size(); m++)
+    {
+        if(check_move(moves[m].first, moves[m].second))
+        {
+            std::cout << "error: failed to " << (removeTracked ? "move " : "copy ") << quote(moves[m].first) << " to " << quote(moves[m].second);
+            std::cout << ", no pages were " << (removeTracked ? "moved" : "copied") << std::endl;
+            return 1;
+        }
+
+        trackedPages.push_back(get_info(moves[m].first));
+        newPages.push_back(moved_info(trackedPages.back(), moves[m].second));
+
+        if(removeTracked)
+        {
+            pages.erase(trackedPages.back());
+            movedNames.insert(trackedPages.back().pageName);
+        }
+        pages.insert(newPages.back());
+
+        changedNames.insert(trackedPages.back().pageName);
+        changedNames.insert(newPages.back().pageName);
+    }
+
+    for(size_t m=0; m<moves.size(); m++)
+    {
+        copy_content(trackedPages[m], newPages[m]);
+        if(removeTracked)
+            remove_page_files(trackedPages[m], 1);
+    }
+
+    if(buildState && movedNames.size())
+        forget_built_pages(movedNames, pages);
+
+    //adds what each changed name ends up as to the pages.list journal in one go
+    std::vector<Name> removedNames;
+    std::vector<PageInfo> updatedPages;
+    for(auto name=changedNames.begin(); name!=changedNames.end(); name++)
+    {
+        if(tracking(*name))
+            updatedPages.push_back(get_info(*name));
+        else
+            removedNames.push_back(*name);
+    }
+    save_page_changes(removedNames, updatedPages);
+
+    std::cout << std::endl;
+    std::cout << "successfully " << (removeTracked ? "moved " : "copied ") << moves.size() << " pages" << std::endl;
+
+    return 0;
+}
+
+int SiteInfo::mv_many(const std::vector<std::pair<Name, Name> > &moves)
+{
+    return move_many(moves, 1);
+}
+
+int SiteInfo::cp_many(const std::vector<std::pair<Name, Name> > &copies)
+{
+    return move_many(copies, 0);
+}
+
 int SiteInfo::new_title(const Name &pageName, const Title &newTitle)
 {
     if(newTitle.str == "")
@@ -818,10 +1332,9 @@ int SiteInfo::new_title(const Name &pageName, const Title &newTitle)
     if(pages.count(pageInfo))
     {
         pageInfo = *(pages.find(pageInfo));
-        pages.erase(pageInfo);
         pageInfo.pageTitle = newTitle;
-        pages.insert(pageInfo);
-        save_pages();
+        pages.update(pageInfo);
+        save_page_changes(std::vector<Name>(), std::vector<PageInfo>(1, pageInfo));
 
         //informs user that page title was successfully changed
         std::cout << "successfully changed page title to " << quote(newTitle.str) << std::endl;
@@ -848,27 +1361,16 @@ int SiteInfo::new_template(const Path &newTemplatePath)
         return 1;
     }
 
-    Name pageName;
-    Title pageTitle;
-    Path pageTemplatePath;
-    rename(".siteinfo/pages.list", ".siteinfo/pages.list-old");
-    std::ifstream ifs(".siteinfo/pages.list-old");
-    std::ofstream ofs(".siteinfo/pages.list");
-    while(read_quoted(ifs, pageName))
-    {
-        pageTitle.read_quoted_from(ifs);
-        pageTemplatePath.read_file_path_from(ifs);
-
-        ofs << quote(pageName) << std::endl;
-        ofs << pageTitle << std::endl;
-        if(pageTemplatePath == defaultTemplate)
-            ofs << newTemplatePath << std::endl << std::endl;
-        else
-            ofs << pageTemplatePath << std::endl << std::endl;
+    PageSet updatedPages;
+    for(auto page=pages.begin(); page!=pages.end(); page++)
+    {
+        PageInfo updatedPage = *page;
+        if(updatedPage.templatePath == defaultTemplate)
+            updatedPage.templatePath = newTemplatePath;
+        updatedPages.insert(updatedPage);
     }
-    ifs.close();
-    ofs.close();
-    Path(".siteinfo/", "pages.list-old").removePath();
+    pages.swap(updatedPages);
+    save_pages();
 
     //sets new template
     defaultTemplate = newTemplatePath;
@@ -903,10 +1405,9 @@ int SiteInfo::new_template(const Name &pageName, const Path &newTemplatePath)
     if(pages.count(pageInfo))
     {
         pageInfo = *(pages.find(pageInfo));
-        pages.erase(pageInfo);
         pageInfo.templatePath = newTemplatePath;
-        pages.insert(pageInfo);
-        save_pages();
+        pages.update(pageInfo);
+        save_page_changes(std::vector<Name>(), std::vector<PageInfo>(1, pageInfo));
 
         //warns user if new template path doesn't exist
         if(!std::ifstream(newTemplatePath.str()))
@@ -1232,39 +1733,36 @@ int SiteInfo::new_content_ext(const std::string &newExt)
         return 1;
     }
 
+    std::string oldExt = contentExt;
     contentExt = newExt;
 
     save_config();
 
+    PageSet updatedPages;
     for(auto page=pages.begin(); page!=pages.end(); page++)
     {
-        //checks for non-default page extension
-        Path extPath = page->pagePath.getInfoPath();
-        extPath.file = extPath.file.substr(0, extPath.file.find_first_of('.')) + ".contExt";
+        PageInfo updatedPage = *page;
 
-        if(std::ifstream(extPath.str()))
+        //pages with a non-default content extension keep it
+        if(page->contentExt == oldExt)
         {
-            std::ifstream ifs(extPath.str());
-            std::string oldExt;
+            Path newContPath = page->contentPath;
+            newContPath.set_file(newContPath.file().substr(0, newContPath.file().find_first_of('.')) + newExt);
 
-            read_quoted(ifs, oldExt);
-            ifs.close();
-
-            if(oldExt == newExt)
-                extPath.removePath();
-        }
-        else
-        {
             //moves the content file
-            if(std::ifstream(page->contentPath.str()))
-            {
-                Path newContPath = page->contentPath;
-                newContPath.file = newContPath.file.substr(0, newContPath.file.find_first_of('.')) + newExt;
-                if(newContPath.str() != page->contentPath.str())
-                    rename(page->contentPath.str().c_str(), newContPath.str().c_str());
-            }
+            if(std::ifstream(page->contentPath.str()) && newContPath.str() != page->contentPath.str())
+                rename(page->contentPath.str().c_str(), newContPath.str().c_str());
+
+            updatedPage.contentPath = newContPath;
+            updatedPage.contentExt = newExt;
         }
+
+        updatedPages.insert(updatedPage);
     }
+    pages.swap(updatedPages);
+
+    //saves pages as those already on the new extension no longer override it
+    save_pages();
 
     //informs user that page extension was successfully changed
     std::cout << "successfully changed content extension to " << quote(newExt) << std::endl;
@@ -1280,59 +1778,32 @@ int SiteInfo::new_content_ext(const Name &pageName, const std::string &newExt)
         return 1;
     }
 
-    PageInfo pageInfo = get_info(pageName);
-    if(pages.count(pageInfo))
+    if(!tracking(pageName))
     {
-        //checks for non-default page extension
-        Path extPath = pageInfo.pagePath.getInfoPath();
-        extPath.file = extPath.file.substr(0, extPath.file.find_first_of('.')) + ".contExt";
-
-        std::string oldExt;
-        if(std::ifstream(extPath.str()))
-        {
-            std::ifstream ifs(extPath.str());
-            getline(ifs, oldExt);
-            ifs.close();
-        }
-        else
-            oldExt = contentExt;
-
-        if(oldExt == newExt)
-        {
-            std::cout << "error: content extension for " << quote(pageName) << " is already " << quote(oldExt) << std::endl;
-            return 1;
-        }
-
-        //makes sure we can write to ext file
-        chmod(extPath.str().c_str(), 0644);
-
-        if(newExt != contentExt)
-        {
-            std::ofstream ofs(extPath.str());
-            ofs << newExt << "\n";
-            ofs.close();
+        std::cout << "error: Nift is not tracking " << quote(pageName) << std::endl;
+        return 1;
+    }
 
-            //makes sure user can't edit ext file
-            chmod(extPath.str().c_str(), 0444);
-        }
-        else
-            extPath.removePath();
+    PageInfo pageInfo = get_info(pageName);
 
-        //moves the content file
-        if(std::ifstream(pageInfo.contentPath.str()))
-        {
-            Path newContPath = pageInfo.contentPath;
-            newContPath.file = newContPath.file.substr(0, newContPath.file.find_first_of('.')) + newExt;
-            if(newContPath.str() != pageInfo.contentPath.str())
-                rename(pageInfo.contentPath.str().c_str(), newContPath.str().c_str());
-        }
-    }
-    else
+    if(pageInfo.contentExt == newExt)
     {
-        std::cout << "error: Nift is not tracking " << quote(pageName) << std::endl;
+        std::cout << "error: content extension for " << quote(pageName) << " is already " << quote(newExt) << std::endl;
         return 1;
     }
 
+    Path newContPath = pageInfo.contentPath;
+    newContPath.set_file(newContPath.file().substr(0, newContPath.file().find_first_of('.')) + newExt);
+
+    //moves the content file
+    if(std::ifstream(pageInfo.contentPath.str()) && newContPath.str() != pageInfo.contentPath.str())
+        rename(pageInfo.contentPath.str().c_str(), newContPath.str().c_str());
+
+    pageInfo.contentPath = newContPath;
+    pageInfo.contentExt = newExt;
+    pages.update(pageInfo);
+    save_page_changes(std::vector<Name>(), std::vector<PageInfo>(1, pageInfo));
+
     return 0;
 }
 
@@ -1350,39 +1821,36 @@ int SiteInfo::new_page_ext(const std::string &newExt)
         return 1;
     }
 
+    std::string oldExt = pageExt;
     pageExt = newExt;
 
     save_config();
 
+    PageSet updatedPages;
     for(auto page=pages.begin(); page!=pages.end(); page++)
     {
-        //checks for non-default page extension
-        Path extPath = page->pagePath.getInfoPath();
-        extPath.file = extPath.file.substr(0, extPath.file.find_first_of('.')) + ".pageExt";
+        PageInfo updatedPage = *page;
 
-        if(std::ifstream(extPath.str()))
+        //pages with a non-default page extension keep it
+        if(page->pageExt == oldExt)
         {
-            std::ifstream ifs(extPath.str());
-            std::string oldExt;
-
-            read_quoted(ifs, oldExt);
-            ifs.close();
+            Path newPagePath = page->pagePath;
+            newPagePath.set_file(newPagePath.file().substr(0, newPagePath.file().find_first_of('.')) + newExt);
 
-            if(oldExt == newExt)
-                extPath.removePath();
-        }
-        else
-        {
             //moves the built page
-            if(std::ifstream(page->pagePath.str()))
-            {
-                Path newPagePath = page->pagePath;
-                newPagePath.file = newPagePath.file.substr(0, newPagePath.file.find_first_of('.')) + newExt;
-                if(newPagePath.str() != page->pagePath.str())
-                    rename(page->pagePath.str().c_str(), newPagePath.str().c_str());
-            }
+            if(std::ifstream(page->pagePath.str()) && newPagePath.str() != page->pagePath.str())
+                rename(page->pagePath.str().c_str(), newPagePath.str().c_str());
+
+            updatedPage.pagePath = newPagePath;
+            updatedPage.pageExt = newExt;
         }
+
+        updatedPages.insert(updatedPage);
     }
+    pages.swap(updatedPages);
+
+    //saves pages as those already on the new extension no longer override it
+    save_pages();
 
     //informs user that page extension was successfully changed
     std::cout << "successfully changed page extension to " << quote(newExt) << std::endl;
@@ -1398,59 +1866,32 @@ int SiteInfo::new_page_ext(const Name &pageName, const std::string &newExt)
         return 1;
     }
 
-    PageInfo pageInfo = get_info(pageName);
-    if(pages.count(pageInfo))
+    if(!tracking(pageName))
     {
-        //checks for non-default page extension
-        Path extPath = pageInfo.pagePath.getInfoPath();
-        extPath.file = extPath.file.substr(0, extPath.file.find_first_of('.')) + ".pageExt";
-
-        std::string oldExt;
-        if(std::ifstream(extPath.str()))
-        {
-            std::ifstream ifs(extPath.str());
-            getline(ifs, oldExt);
-            ifs.close();
-        }
-        else
-            oldExt = pageExt;
-
-        if(oldExt == newExt)
-        {
-            std::cout << "error: page extension for " << quote(pageName) << " is already " << quote(oldExt) << std::endl;
-            return 1;
-        }
-
-        //makes sure we can write to ext file
-        chmod(extPath.str().c_str(), 0644);
-
-        if(newExt != pageExt)
-        {
-            std::ofstream ofs(extPath.str());
-            ofs << newExt << "\n";
-            ofs.close();
+        std::cout << "error: Nift is not tracking " << quote(pageName) << std::endl;
+        return 1;
+    }
 
-            //makes sure user can't edit ext file
-            chmod(extPath.str().c_str(), 0444);
-        }
-        else
-            extPath.removePath();
+    PageInfo pageInfo = get_info(pageName);
 
-        //moves the built page
-        if(std::ifstream(pageInfo.pagePath.str()))
-        {
-            Path newPagePath = pageInfo.pagePath;
-            newPagePath.file = newPagePath.file.substr(0, newPagePath.file.find_first_of('.')) + newExt;
-            if(newPagePath.str() != pageInfo.pagePath.str())
-                rename(pageInfo.pagePath.str().c_str(), newPagePath.str().c_str());
-        }
-    }
-    else
+    if(pageInfo.pageExt == newExt)
     {
-        std::cout << "error: Nift is not tracking " << quote(pageName) << std::endl;
+        std::cout << "error: page extension for " << quote(pageName) << " is already " << quote(newExt) << std::endl;
         return 1;
     }
 
+    Path newPagePath = pageInfo.pagePath;
+    newPagePath.set_file(newPagePath.file().substr(0, newPagePath.file().find_first_of('.')) + newExt);
+
+    //moves the built page
+    if(std::ifstream(pageInfo.pagePath.str()) && newPagePath.str() != pageInfo.pagePath.str())
+        rename(pageInfo.pagePath.str().c_str(), newPagePath.str().c_str());
+
+    pageInfo.pagePath = newPagePath;
+    pageInfo.pageExt = newExt;
+    pages.update(pageInfo);
+    save_page_changes(std::vector<Name>(), std::vector<PageInfo>(1, pageInfo));
+
     return 0;
 }
 
@@ -1468,28 +1909,26 @@ int SiteInfo::new_script_ext(const std::string &newExt)
         return 1;
     }
 
+    std::string oldExt = scriptExt;
     scriptExt = newExt;
 
     save_config();
 
+    PageSet updatedPages;
     for(auto page=pages.begin(); page!=pages.end(); page++)
     {
-        //checks for non-default page extension
-        Path extPath = page->pagePath.getInfoPath();
-        extPath.file = extPath.file.substr(0, extPath.file.find_first_of('.')) + ".scriptExt";
-
-        if(std::ifstream(extPath.str()))
-        {
-            std::ifstream ifs(extPath.str());
-            std::string oldExt;
+        PageInfo updatedPage = *page;
 
-            read_quoted(ifs, oldExt);
-            ifs.close();
+        //pages with a non-default script extension keep it
+        if(page->scriptExt == oldExt)
+            updatedPage.scriptExt = newExt;
 
-            if(oldExt == newExt)
-                extPath.removePath();
-        }
+        updatedPages.insert(updatedPage);
     }
+    pages.swap(updatedPages);
+
+    //saves pages as those already on the new extension no longer override it
+    save_pages();
 
     //informs user that page extension was successfully changed
     std::cout << "successfully changed script extension to " << quote(newExt) << std::endl;
@@ -1505,50 +1944,24 @@ int SiteInfo::new_script_ext(const Name &pageName, const std::string &newExt)
         return 1;
     }
 
-    PageInfo pageInfo = get_info(pageName);
-    if(pages.count(pageInfo))
+    if(!tracking(pageName))
     {
-        //checks for non-default script extension
-        Path extPath = pageInfo.pagePath.getInfoPath();
-        extPath.file = extPath.file.substr(0, extPath.file.find_first_of('.')) + ".scriptExt";
-
-        std::string oldExt;
-        if(std::ifstream(extPath.str()))
-        {
-            std::ifstream ifs(extPath.str());
-            getline(ifs, oldExt);
-            ifs.close();
-        }
-        else
-            oldExt = scriptExt;
-
-        if(oldExt == newExt)
-        {
-            std::cout << "error: script extension for " << quote(pageName) << " is already " << quote(oldExt) << std::endl;
-            return 1;
-        }
-
-        //makes sure we can write to ext file
-        chmod(extPath.str().c_str(), 0644);
+        std::cout << "error: Nift is not tracking " << quote(pageName) << std::endl;
+        return 1;
+    }
 
-        if(newExt != pageExt)
-        {
-            std::ofstream ofs(extPath.str());
-            ofs << newExt << "\n";
-            ofs.close();
+    PageInfo pageInfo = get_info(pageName);
 
-            //makes sure user can't edit ext file
-            chmod(extPath.str().c_str(), 0444);
-        }
-        else
-            extPath.removePath();
-    }
-    else
+    if(pageInfo.scriptExt == newExt)
     {
-        std::cout << "error: Nift is not tracking " << quote(pageName) << std::endl;
+        std::cout << "error: script extension for " << quote(pageName) << " is already " << quote(newExt) << std::endl;
         return 1;
     }
 
+    pageInfo.scriptExt = newExt;
+    pages.update(pageInfo);
+    save_page_changes(std::vector<Name>(), std::vector<PageInfo>(1, pageInfo));
+
     return 0;
 }
 
@@ -1560,13 +1973,14 @@ int SiteInfo::no_build_threads(int no_threads)
         return 1;
     }
 
-    if(no_threads == buildThreads)
+    if(no_threads == buildThreads && !autoBuildThreads)
     {
         std::cout << "error: number of build threads is already " << buildThreads << std::endl;
         return 1;
     }
 
     buildThreads = no_threads;
+    autoBuildThreads = 0;
     save_config();
 
     std::cout << "successfully changed number of build threads to " << no_threads << std::endl;
@@ -1574,29 +1988,109 @@ int SiteInfo::no_build_threads(int no_threads)
     return 0;
 }
 
-std::mutex os_mtx;
-
-int SiteInfo::build(const std::vector<Name>& pageNamesToBuild)
+int SiteInfo::auto_build_threads()
 {
-    PageBuilder pageBuilder(&pages, &os_mtx, contentDir, siteDir, contentExt, pageExt, scriptExt, defaultTemplate, unixTextEditor, winTextEditor);
-    std::set<Name> untrackedPages, failedPages;
-
-    for(auto pageName=pageNamesToBuild.begin(); pageName != pageNamesToBuild.end(); pageName++)
+    if(autoBuildThreads)
     {
-        if(tracking(*pageName))
-        {
-            if(pageBuilder.build(get_info(*pageName), std::cout) > 0)
-                failedPages.insert(*pageName);
-        }
-        else
-            untrackedPages.insert(*pageName);
+        std::cout << "error: number of build threads is already auto" << std::endl;
+        return 1;
     }
 
-    if(failedPages.size() > 0)
-    {
-        std::cout << std::endl;
-        std::cout << "---- following pages failed to build ----" << std::endl;
-        for(auto fName=failedPages.begin(); fName != failedPages.end(); fName++)
+    buildThreads = -1;
+    autoBuildThreads = 1;
+    save_config();
+
+    std::cout << "successfully changed number of build threads to auto" << std::endl;
+
+    return 0;
+}
+
+//gets the number of threads to use for checking dependencies and building pages
+int SiteInfo::get_no_threads(int& noDepThreads, int& noBuildThreads)
+{
+    int noCores = std::thread::hardware_concurrency();
+    if(noCores < 1)
+        noCores = 1;
+
+    if(buildThreads < 0)
+        noDepThreads = -buildThreads*noCores;
+    else
+        noDepThreads = buildThreads;
+
+    //auto mode spawns enough threads to cover i/o bound sites, only some of them are made active
+    if(autoBuildThreads)
+        noBuildThreads = 8*noCores;
+    else
+        noBuildThreads = noDepThreads;
+
+    return 0;
+}
+
+//works out the time given by build time directives (eg. @builddate), for reproducible builds it is
+//pinned by SOURCE_DATE_EPOCH or buildTime in the config file, "deps" pins it per page instead
+int SiteInfo::get_build_time(DateTimeInfo& buildDateTime, bool& depsBuildTime)
+{
+    std::string pinnedTime = buildTime;
+    const char* sourceDateEpoch = std::getenv("SOURCE_DATE_EPOCH");
+    if(sourceDateEpoch && std::string(sourceDateEpoch) != "")
+        pinnedTime = sourceDateEpoch;
+
+    depsBuildTime = (pinnedTime == "deps");
+    if(pinnedTime == "" || depsBuildTime)
+    {
+        buildDateTime.set(time(0));
+        return 0;
+    }
+
+    long long int seconds;
+    std::istringstream iss(pinnedTime);
+    if(!(iss >> seconds) || !iss.eof())
+    {
+        std::cout << "error: build time " << quote(pinnedTime) << " should be seconds since the epoch or deps" << std::endl;
+        return 1;
+    }
+    buildDateTime.set((time_t)seconds);
+
+    return 0;
+}
+
+std::mutex os_mtx;
+
+int SiteInfo::build(const std::vector<Name>& pageNamesToBuild)
+{
+    PageBuilder pageBuilder(&pages, &os_mtx, contentDir, siteDir, contentExt, pageExt, scriptExt, defaultTemplate, unixTextEditor, winTextEditor);
+    pageBuilder.parallelInputs = parallelInputs;
+    if(get_build_time(pageBuilder.dateTimeInfo, pageBuilder.depsBuildTime))
+        return 1;
+    depIndex.hashDeps = hashDeps;
+    depIndex.buildState = buildState;
+    depIndex.reverseIndex = 0;
+    pageBuilder.depIndex = &depIndex;
+    depIndex.open(); //for the output hashes of pages
+    std::set<Name> untrackedPages, failedPages, unchangedPages;
+
+    statCache.clear();
+
+    for(auto pageName=pageNamesToBuild.begin(); pageName != pageNamesToBuild.end(); pageName++)
+    {
+        if(tracking(*pageName))
+        {
+            if(pageBuilder.build(get_info(*pageName), std::cout) > 0)
+                failedPages.insert(*pageName);
+            else if(pageBuilder.unchanged)
+                unchangedPages.insert(*pageName);
+        }
+        else
+            untrackedPages.insert(*pageName);
+    }
+
+    depIndex.save(&pages);
+
+    if(failedPages.size() > 0)
+    {
+        std::cout << std::endl;
+        std::cout << "---- following pages failed to build ----" << std::endl;
+        for(auto fName=failedPages.begin(); fName != failedPages.end(); fName++)
             std::cout << " " << *fName << std::endl;
         std::cout << "-----------------------------------------" << std::endl;
     }
@@ -1608,6 +2102,14 @@ int SiteInfo::build(const std::vector<Name>& pageNamesToBuild)
             std::cout << " " << *uName << std::endl;
         std::cout << "-------------------------------------------" << std::endl;
     }
+    if(unchangedPages.size() > 0)
+    {
+        std::cout << std::endl;
+        std::cout << "---- built pages with unchanged output ----" << std::endl;
+        for(auto uName=unchangedPages.begin(); uName != unchangedPages.end(); uName++)
+            std::cout << " " << *uName << std::endl;
+        std::cout << "-------------------------------------------" << std::endl;
+    }
     if(failedPages.size() == 0 && untrackedPages.size() == 0)
     {
         std::cout << std::endl;
@@ -1617,19 +2119,58 @@ int SiteInfo::build(const std::vector<Name>& pageNamesToBuild)
     return 0;
 }
 
-std::mutex fail_mtx, built_mtx, set_mtx;
-std::set<Name> failedPages, builtPages;
-std::set<PageInfo>::iterator cPage;
+std::mutex set_mtx;
+std::vector<Name> failedPages, builtPages, unchangedPages;
+std::vector<std::pair<Name, double> > buildTimes; //seconds taken building each page
+PageSet::iterator cPage;
 
 std::atomic<int> counter;
 
-void build_thread(std::ostream& os, std::set<PageInfo>* pages, const int& no_pages, const Directory& ContentDir, const Directory& SiteDir, const std::string& ContentExt, const std::string& PageExt, const std::string& ScriptExt, const Path& DefaultTemplate, const std::string& UnixTextEditor, const std::string& WinTextEditor)
+//merges results collected by each thread into one sorted list without duplicates
+template <class T>
+void merge_results(std::vector<std::vector<T> >& threadResults, std::vector<T>& results)
+{
+    size_t total = 0;
+    for(size_t t=0; t<threadResults.size(); t++)
+        total += threadResults[t].size();
+
+    results.clear();
+    results.reserve(total);
+    for(size_t t=0; t<threadResults.size(); t++)
+        results.insert(results.end(), threadResults[t].begin(), threadResults[t].end());
+
+    std::sort(results.begin(), results.end());
+    results.erase(std::unique(results.begin(), results.end()), results.end());
+}
+
+//used for adapting the number of active build threads in auto mode
+std::atomic<int> activeThreads, completed;
+std::atomic<long long int> blockedTime; //microseconds
+std::mutex active_mtx;
+std::condition_variable active_cv;
+
+void build_thread(std::ostream& os, const int threadNo, PageSet* pages, const int& no_pages, std::vector<Name>* built, std::vector<Name>* unchanged, std::vector<Name>* failed, std::vector<std::pair<Name, double> >* times, const Directory& ContentDir, const Directory& SiteDir, const std::string& ContentExt, const std::string& PageExt, const std::string& ScriptExt, const Path& DefaultTemplate, const std::string& UnixTextEditor, const std::string& WinTextEditor, const int& ParallelInputs, const DateTimeInfo& BuildDateTime, const bool& DepsBuildTime, DepIndex* depIndex, PageIndex* pageIndex)
 {
     PageBuilder pageBuilder(pages, &os_mtx, ContentDir, SiteDir, ContentExt, PageExt, ScriptExt, DefaultTemplate, UnixTextEditor, WinTextEditor);
-    std::set<PageInfo>::iterator pageInfo;
+    pageBuilder.parallelInputs = ParallelInputs;
+    pageBuilder.dateTimeInfo = BuildDateTime;
+    pageBuilder.depsBuildTime = DepsBuildTime;
+    pageBuilder.depIndex = depIndex;
+    pageBuilder.pageIndex = pageIndex;
+    PageSet::iterator pageInfo;
+    Timer timer;
+    double cpuTime;
 
     while(counter < no_pages)
     {
+        //waits while this thread isn't one of the active threads
+        if(threadNo >= activeThreads)
+        {
+            std::unique_lock<std::mutex> lock(active_mtx);
+            active_cv.wait(lock, [&]{ return threadNo < activeThreads || counter >= no_pages; });
+            continue;
+        }
+
         set_mtx.lock();
         if(counter >= no_pages)
         {
@@ -1640,40 +2181,393 @@ void build_thread(std::ostream& os, std::set<PageInfo>* pages, const int& no_pag
         pageInfo = cPage++;
         set_mtx.unlock();
 
+        //wakes any waiting threads once all pages have been taken
+        if(counter == no_pages)
+        {
+            active_mtx.lock();
+            active_mtx.unlock();
+            active_cv.notify_all();
+        }
+
+        timer.start();
+        cpuTime = threadCPUTime();
+
+        //results are kept per thread and merged after the threads have joined
         if(pageBuilder.build(*pageInfo, os) > 0)
+            failed->push_back(pageInfo->pageName);
+        else
+        {
+            built->push_back(pageInfo->pageName);
+            if(pageBuilder.unchanged)
+                unchanged->push_back(pageInfo->pageName);
+        }
+        times->push_back(std::pair<Name, double>(pageInfo->pageName, timer.getTime()));
+
+        //time spent building that wasn't spent on this thread's cpu (i/o, subprocesses, etc.)
+        if(cpuTime >= 0)
         {
-            fail_mtx.lock();
-            failedPages.insert(pageInfo->pageName);
-            fail_mtx.unlock();
+            double blocked = timer.getTime() - (threadCPUTime() - cpuTime);
+            if(blocked > 0)
+                blockedTime += (long long int)(blocked*1000000);
         }
-		else
-		{
-			built_mtx.lock();
-			builtPages.insert(pageInfo->pageName);
-			built_mtx.unlock();
-		}
+        completed++;
     }
 }
 
-int SiteInfo::build_all()
+/*
+    adjusts the number of active build threads until all pages have been taken,
+    grows when threads spend most of their time blocked and shrinks back
+    towards the number of cores when they don't or throughput drops
+*/
+void adapt_build_threads(const int& no_threads, const int& no_pages)
 {
-    int no_threads;
-    if(buildThreads < 0)
-        no_threads = -buildThreads*std::thread::hardware_concurrency();
+    const double sampleTime = 0.1;
+    int noCores = std::thread::hardware_concurrency();
+    if(noCores < 1)
+        noCores = 1;
+
+    Timer timer;
+    int lastCompleted = 0,
+        lastChange = 0;
+    long long int lastBlocked = 0;
+    double lastRate = 0;
+
+    timer.start();
+    while(counter < no_pages)
+    {
+        {
+            std::unique_lock<std::mutex> lock(active_mtx);
+            active_cv.wait_for(lock, std::chrono::milliseconds((int)(sampleTime*1000)), [&]{ return counter >= no_pages; });
+        }
+        if(counter >= no_pages)
+            break;
+
+        double dt = timer.getTime();
+        timer.start();
+        int cCompleted = completed,
+            cActive = activeThreads;
+        long long int cBlocked = blockedTime;
+        double rate = (cCompleted - lastCompleted)/dt,
+               blockedFrac = (cBlocked - lastBlocked)/(1000000.0*dt*cActive);
+
+        if(lastChange > 0 && rate < 0.95*lastRate && cActive > 1)
+            lastChange = -lastChange; //growing didn't help, backs off
+        else if(blockedFrac > 0.3 && cActive < no_threads)
+            lastChange = std::min(std::max(1, cActive/4), no_threads - cActive);
+        else if(blockedFrac < 0.1 && cActive > noCores)
+            lastChange = -1;
+        else
+            lastChange = 0;
+
+        if(lastChange)
+        {
+            active_mtx.lock();
+            activeThreads += lastChange;
+            active_mtx.unlock();
+            active_cv.notify_all();
+        }
+
+        lastCompleted = cCompleted;
+        lastBlocked = cBlocked;
+        lastRate = rate;
+    }
+}
+
+//spawns build threads over no_pages pages starting from cPage, merging their results into builtPages, unchangedPages and failedPages
+void run_build_threads(std::ostream& os, const int& no_threads, const bool& autoThreads, PageSet* pages, const int& no_pages, const Directory& ContentDir, const Directory& SiteDir, const std::string& ContentExt, const std::string& PageExt, const std::string& ScriptExt, const Path& DefaultTemplate, const std::string& UnixTextEditor, const std::string& WinTextEditor, const int& ParallelInputs, const DateTimeInfo& BuildDateTime, const bool& DepsBuildTime, DepIndex* depIndex, PageIndex* pageIndex)
+{
+    std::vector<std::vector<Name> > threadBuilt(no_threads), threadUnchanged(no_threads), threadFailed(no_threads);
+    std::vector<std::vector<std::pair<Name, double> > > threadTimes(no_threads);
+
+    completed = 0;
+    blockedTime = 0;
+    if(autoThreads)
+    {
+        activeThreads = std::thread::hardware_concurrency();
+        if(activeThreads < 1)
+            activeThreads = 1;
+    }
     else
-        no_threads = buildThreads;
+        activeThreads = no_threads;
+
+    std::vector<std::thread> threads;
+    for(int i=0; i<no_threads; i++)
+        threads.push_back(std::thread(build_thread, std::ref(os), i, pages, no_pages, &threadBuilt[i], &threadUnchanged[i], &threadFailed[i], &threadTimes[i], ContentDir, SiteDir, ContentExt, PageExt, ScriptExt, DefaultTemplate, UnixTextEditor, WinTextEditor, ParallelInputs, BuildDateTime, DepsBuildTime, depIndex, pageIndex));
+
+    if(autoThreads)
+        adapt_build_threads(no_threads, no_pages);
+
+    for(int i=0; i<no_threads; i++)
+        threads[i].join();
+
+    merge_results(threadBuilt, builtPages);
+    merge_results(threadUnchanged, unchangedPages);
+    merge_results(threadFailed, failedPages);
+    merge_results(threadTimes, buildTimes);
+}
+
+int SiteInfo::set_shard(const int& ShardNo, const int& NoShards, const bool& byCost)
+{
+    if(NoShards < 1 || ShardNo < 1 || ShardNo > NoShards)
+    {
+        std::cout << "error: invalid shard " << ShardNo << "/" << NoShards << ", shard number should be between 1 and the number of shards" << std::endl;
+        return 1;
+    }
+
+    shardNo = ShardNo;
+    noShards = NoShards;
+    shardByCost = byCost;
+
+    return 0;
+}
+
+//reads historical page build times saved by merge-shards
+void read_build_costs(std::map<Name, double>& costs)
+{
+    std::ifstream ifs(".siteinfo/build.costs");
+    double cost;
+    Name pageName;
+
+    while(ifs >> cost && read_quoted(ifs, pageName))
+        costs[pageName] = cost;
+
+    ifs.close();
+}
+
+/*
+    selects the pages belonging to this process's shard, either by hash of
+    page name or by spreading the historical build times evenly across the
+    shards (longest first onto the least loaded shard). both are deterministic
+    so each process works out the same partition independently
+*/
+int SiteInfo::get_shard_pages(PageSet& shardPages)
+{
+    shardPages.clear();
+
+    if(!shardByCost)
+    {
+        for(auto page=pages.begin(); page!=pages.end(); page++)
+            if((int)(fnv1a(page->pageName) % noShards) == shardNo-1)
+                shardPages.insert(*page);
+
+        return 0;
+    }
+
+    std::map<Name, double> costs;
+    read_build_costs(costs);
+
+    //pages without a build time yet are assumed to take the average time
+    double avgCost = 0;
+    int noCosts = 0;
+    for(auto page=pages.begin(); page!=pages.end(); page++)
+    {
+        auto cost = costs.find(page->pageName);
+        if(cost != costs.end())
+        {
+            avgCost += cost->second;
+            noCosts++;
+        }
+    }
+    if(noCosts)
+        avgCost /= noCosts;
+    else
+        avgCost = 1;
+
+    std::vector<std::pair<double, PageSet::iterator> > pageCosts;
+    pageCosts.reserve(pages.size());
+    for(auto page=pages.begin(); page!=pages.end(); page++)
+    {
+        auto cost = costs.find(page->pageName);
+        pageCosts.push_back(std::make_pair(cost != costs.end() ? cost->second : avgCost, page));
+    }
+
+    //stable so pages with equal times stay in name order
+    std::stable_sort(pageCosts.begin(), pageCosts.end(),
+        [](const std::pair<double, PageSet::iterator>& a, const std::pair<double, PageSet::iterator>& b) { return a.first > b.first; });
+
+    std::vector<double> loads(noShards, 0);
+    for(size_t p=0; p<pageCosts.size(); p++)
+    {
+        int s = std::min_element(loads.begin(), loads.end()) - loads.begin();
+        loads[s] += pageCosts[p].first;
+        if(s == shardNo-1)
+            shardPages.insert(*pageCosts[p].second);
+    }
+
+    return 0;
+}
+
+std::string shard_summary_path(const int& shardNo, const int& noShards)
+{
+    return ".siteinfo/shards/" + std::to_string(shardNo) + "-of-" + std::to_string(noShards) + ".summary";
+}
+
+//saves which pages this shard built or failed to build and how long each took
+int SiteInfo::save_shard_summary(const std::string& buildType)
+{
+    Path(".siteinfo/shards/", "").ensurePathExists();
+
+    std::string summaryPath = shard_summary_path(shardNo, noShards);
+    std::ofstream ofs(summaryPath + ".tmp");
+    ofs << "shard " << shardNo << "/" << noShards << " " << buildType << "\n";
+    for(auto bTime=buildTimes.begin(); bTime!=buildTimes.end(); bTime++)
+    {
+        if(std::binary_search(failedPages.begin(), failedPages.end(), bTime->first))
+            ofs << "failed ";
+        else
+            ofs << "built ";
+        ofs << bTime->second << " " << quote(bTime->first) << "\n";
+    }
+    ofs.close();
+
+    //a half written summary would lose pages when merging, so the old one is left in place
+    if(!ofs.good())
+    {
+        std::cout << "error: failed to save shard summary " << quote(summaryPath) << std::endl;
+        std::remove((summaryPath + ".tmp").c_str());
+        return 1;
+    }
+
+    #if defined _WIN32 || defined _WIN64
+        std::remove(summaryPath.c_str());
+    #endif
+    std::rename((summaryPath + ".tmp").c_str(), summaryPath.c_str());
+
+    return 0;
+}
+
+int SiteInfo::merge_shards(const int& NoShards)
+{
+    if(NoShards < 1)
+    {
+        std::cout << "error: number of shards should be a positive integer" << std::endl;
+        return 1;
+    }
+
+    std::map<Name, double> costs;
+    std::set<Name> built, failed;
+    std::vector<int> missingShards;
+    std::string result, header;
+    double cost;
+    Name pageName;
+
+    read_build_costs(costs);
+
+    for(int s=1; s<=NoShards; s++)
+    {
+        std::ifstream ifs(shard_summary_path(s, NoShards));
+        if(!ifs)
+        {
+            missingShards.push_back(s);
+            continue;
+        }
+
+        getline(ifs, header);
+        while(ifs >> result >> cost && read_quoted(ifs, pageName))
+        {
+            if(result == "failed")
+                failed.insert(pageName);
+            else
+                built.insert(pageName);
+            costs[pageName] = cost;
+        }
+
+        ifs.close();
+    }
+
+    //saves updated build times of tracked pages to be used by --shard-cost
+    std::ofstream ofs(".siteinfo/build.costs.tmp");
+    for(auto pCost=costs.begin(); pCost!=costs.end(); pCost++)
+        if(tracking(pCost->first))
+            ofs << pCost->second << " " << quote(pCost->first) << "\n";
+    ofs.close();
+
+    bool costsSaved = ofs.good();
+    if(costsSaved)
+    {
+        #if defined _WIN32 || defined _WIN64
+            std::remove(".siteinfo/build.costs");
+        #endif
+        std::rename(".siteinfo/build.costs.tmp", ".siteinfo/build.costs");
+    }
+    else
+        std::remove(".siteinfo/build.costs.tmp");
+
+    if(failed.size() > 0)
+    {
+        std::cout << std::endl;
+        std::cout << "---- following pages failed to build ----" << std::endl;
+        if(failed.size() < 20)
+            for(auto fName=failed.begin(); fName != failed.end(); fName++)
+                std::cout << " " << *fName << std::endl;
+        else
+        {
+            int x=0;
+            for(auto fName=failed.begin(); x < 20; fName++, x++)
+                std::cout << " " << *fName << std::endl;
+            std::cout << " along with " << failed.size() - 20 << " other pages" << std::endl;
+        }
+        std::cout << "-----------------------------------------" << std::endl;
+    }
+
+    std::cout << "merged " << NoShards - missingShards.size() << " of " << NoShards << " shards: ";
+    std::cout << built.size() << " pages built, " << failed.size() << " pages failed to build" << std::endl;
+
+    if(!costsSaved)
+    {
+        std::cout << "error: failed to save page build times to '.siteinfo/build.costs'" << std::endl;
+        if(missingShards.size() == 0)
+            return 1;
+    }
+
+    if(missingShards.size() > 0)
+    {
+        std::cout << "error: no summary found for shards";
+        for(size_t s=0; s<missingShards.size(); s++)
+            std::cout << " " << missingShards[s] << "/" << NoShards;
+        std::cout << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int SiteInfo::build_all()
+{
+    int no_dep_threads, no_threads;
+    get_no_threads(no_dep_threads, no_threads);
+
+    DateTimeInfo buildDateTime;
+    bool depsBuildTime;
+    if(get_build_time(buildDateTime, depsBuildTime))
+        return 1;
 
     std::set<Name> untrackedPages;
+    depIndex.hashDeps = hashDeps;
+    depIndex.buildState = buildState;
+    depIndex.reverseIndex = 0;
+    depIndex.open(); //for the output hashes of pages
 
-    cPage = pages.begin();
+    statCache.clear();
+
+    //when sharding only this shard's pages are built, other pages are still available to @pathtopage
+    PageSet shardPages;
+    PageSet* pagesToBuild = &pages;
+    if(noShards > 1)
+    {
+        get_shard_pages(shardPages);
+        pagesToBuild = &shardPages;
+        std::cout << "building shard " << shardNo << "/" << noShards << ": " << shardPages.size() << " of " << pages.size() << " pages" << std::endl;
+    }
+
+    cPage = pagesToBuild->begin();
     counter = 0;
 
-	std::vector<std::thread> threads;
-	for(int i=0; i<no_threads; i++)
-		threads.push_back(std::thread(build_thread, std::ref(std::cout), &pages, pages.size(), contentDir, siteDir, contentExt, pageExt, scriptExt, defaultTemplate, unixTextEditor, winTextEditor));
+    run_build_threads(std::cout, no_threads, autoBuildThreads, &pages, pagesToBuild->size(), contentDir, siteDir, contentExt, pageExt, scriptExt, defaultTemplate, unixTextEditor, winTextEditor, parallelInputs, buildDateTime, depsBuildTime, &depIndex, NULL);
+    if(autoBuildThreads && pagesToBuild->size())
+        std::cout << "auto build threads: settled on " << activeThreads << " threads" << std::endl;
 
-	for(int i=0; i<no_threads; i++)
-		threads[i].join();
+    depIndex.save(&pages);
 
     if(failedPages.size() > 0)
     {
@@ -1709,19 +2603,172 @@ int SiteInfo::build_all()
     }
     if(failedPages.size() == 0 && untrackedPages.size() == 0)
         std::cout << "all " << builtPages.size() << " pages built successfully" << std::endl;
+    if(unchangedPages.size() > 0)
+        std::cout << unchangedPages.size() << " pages had unchanged output, their page files were left untouched" << std::endl;
+
+    if(noShards > 1)
+        return save_shard_summary("build-all");
+
+    return 0;
+}
+
+/*
+    builds every page a batch at a time straight from pages.list (through
+    pages.index and the journal) rather than opening the whole site, for
+    sites too large to hold in memory at once. just the number of pages
+    built and the first of those which failed are kept, @pathto and
+    @pathtopage find pages outside the current batch through the index
+*/
+int SiteInfo::build_all_batched()
+{
+    PageIndex pageIndex;
+    if(pagesListVersion < 2 || (pageIndex.open() && (index_pages() || pageIndex.open())))
+    {
+        if(open_pages())
+            return 1;
+        return build_all();
+    }
+    pageIndex.read_journal();
+
+    int no_dep_threads, no_threads;
+    get_no_threads(no_dep_threads, no_threads);
+
+    DateTimeInfo buildDateTime;
+    bool depsBuildTime;
+    if(get_build_time(buildDateTime, depsBuildTime))
+        return 1;
+
+    //entries are read from the index as they're needed and saved after each batch, so they aren't all kept at once
+    DepIndex depIndex;
+    depIndex.hashDeps = hashDeps;
+    depIndex.buildState = buildState;
+    depIndex.reverseIndex = 0;
+    depIndex.batched = 1;
+    depIndex.open(); //for the output hashes of pages
+
+    const size_t batchSize = 4096,
+                 maxListed = 20;
+    size_t noBuilt = 0,
+           noUnchanged = 0,
+           noFailed = 0;
+    std::vector<Name> failedSample; //first failed pages by name
+
+    std::string entries;
+    const char *pos, *end, *changePos;
+    PageInfo inPage, changedPage;
+    bool changed;
+    auto change = pageIndex.journal.begin();
+    for(size_t p=0; p<pageIndex.noPages || change!=pageIndex.journal.end();)
+    {
+        pages.clear();
+
+        //adds the batch's pages in order, taking any changes from the journal in their place
+        size_t q = std::min(p + batchSize, pageIndex.noPages);
+        entries = pageIndex.entries(p, q);
+        pos = entries.c_str();
+        end = pos + entries.size();
+        while(read_page_entry(pos, end, inPage, NULL))
+        {
+            std::string key = quote(inPage.pageName);
+            for(changed = 0; change != pageIndex.journal.end() && change->first <= key; change++)
+            {
+                changed = (change->first == key);
+                changePos = change->second.c_str();
+                if(read_page_entry(changePos, changePos + change->second.size(), changedPage, NULL))
+                    pages.insert(changedPage);
+            }
+            if(!changed)
+                pages.insert(inPage);
+        }
+        p = q;
+
+        //pages added by the journal after the last page in pages.list
+        if(p == pageIndex.noPages)
+        {
+            for(; change != pageIndex.journal.end(); change++)
+            {
+                changePos = change->second.c_str();
+                if(read_page_entry(changePos, changePos + change->second.size(), changedPage, NULL))
+                    pages.insert(changedPage);
+            }
+        }
+
+        statCache.clear();
+        cPage = pages.begin();
+        counter = 0;
+
+        run_build_threads(std::cout, no_threads, autoBuildThreads, &pages, pages.size(), contentDir, siteDir, contentExt, pageExt, scriptExt, defaultTemplate, unixTextEditor, winTextEditor, parallelInputs, buildDateTime, depsBuildTime, &depIndex, &pageIndex);
+        depIndex.save_batch(pages);
+
+        noBuilt += builtPages.size();
+        noUnchanged += unchangedPages.size();
+        noFailed += failedPages.size();
+        failedSample.insert(failedSample.end(), failedPages.begin(), failedPages.end());
+        std::sort(failedSample.begin(), failedSample.end());
+        if(failedSample.size() > maxListed)
+            failedSample.resize(maxListed);
+    }
+    if(autoBuildThreads && noBuilt + noFailed)
+        std::cout << "auto build threads: settled on " << activeThreads << " threads" << std::endl;
+
+    pages.clear();
+    builtPages.clear();
+    unchangedPages.clear();
+    failedPages.clear();
+    buildTimes.clear();
+
+    //every tracked page was in a batch, so the saved index only has entries of tracked pages
+    depIndex.save(NULL);
+
+    if(noFailed > 0)
+    {
+        std::cout << std::endl;
+        std::cout << "---- following pages failed to build ----" << std::endl;
+        for(size_t f=0; f<failedSample.size(); f++)
+            std::cout << " " << failedSample[f] << std::endl;
+        if(noFailed > maxListed)
+            std::cout << " along with " << noFailed - maxListed << " other pages" << std::endl;
+        std::cout << "-----------------------------------------" << std::endl;
+    }
+    else
+        std::cout << "all " << noBuilt << " pages built successfully" << std::endl;
+    if(noUnchanged > 0)
+        std::cout << noUnchanged << " pages had unchanged output, their page files were left untouched" << std::endl;
 
     return 0;
 }
 
-std::mutex problem_mtx, updated_mtx, modified_mtx, removed_mtx;
-std::set<PageInfo> updatedPages;
-std::set<Path> modifiedFiles,
+PageSet updatedPages;
+std::vector<Path> modifiedFiles,
     removedFiles,
     problemPages;
 
-void dep_thread(std::ostream& os, const int& no_pages, const Directory& contentDir, const Directory& siteDir, const std::string& contentExt, const std::string& pageExt)
+//dependency check results from a single dep thread
+struct DepResults
+{
+    std::vector<PageInfo> updated;
+    std::vector<Path> modified,
+        removed,
+        problem;
+    std::vector<std::pair<Name, DepIndexEntry> > indexed; //up to date pages missing from the dependency index
+};
+
+//page name -> (dependency, whether it was removed) for pages with modified or removed dependencies
+typedef std::map<Name, std::pair<Path, bool> > DirtyPages;
+
+//user-defined dependencies listed in a page's .deps file are recorded along with its other dependencies when
+//it's built, gives the page's .deps file when there is one which wasn't recorded (eg. added since the page was built)
+bool unrecorded_deps_file(const PageInfo& page, const std::vector<Path>& deps, Path& depsPath)
+{
+    depsPath = page.contentPath;
+    depsPath.set_file(depsPath.file().substr(0, depsPath.file().find_first_of('.')) + ".deps");
+
+    return statCache.exists(depsPath.str()) && std::find(deps.begin(), deps.end(), depsPath) == deps.end();
+}
+
+void dep_thread(std::ostream& os, const int& no_pages, DepResults* results, const PageSet* trackedPages, const std::map<std::string, std::string>* configValues, const DepIndex* depIndex, const DirtyPages* dirtyPages, const Directory& contentDir, const Directory& siteDir, const std::string& contentExt, const std::string& pageExt)
 {
-    std::set<PageInfo>::iterator page;
+    PageSet::iterator page;
 
     while(counter < no_pages)
     {
@@ -1736,40 +2783,142 @@ void dep_thread(std::ostream& os, const int& no_pages, const Directory& contentD
         set_mtx.unlock();
 
         //checks whether content and template files exist
-        if(!std::ifstream(page->contentPath.str()))
+        if(!statCache.exists(page->contentPath.str()))
         {
             os_mtx.lock();
             os << page->pagePath << ": content file " << page->contentPath << " does not exist" << std::endl;
             os_mtx.unlock();
-            problem_mtx.lock();
-            problemPages.insert(page->pagePath);
-            problem_mtx.unlock();
+            results->problem.push_back(page->pagePath);
             continue;
         }
-        if(!std::ifstream(page->templatePath.str()))
+        if(!statCache.exists(page->templatePath.str()))
         {
             os_mtx.lock();
             os << page->pagePath << ": template file " << page->templatePath << " does not exist" << std::endl;
             os_mtx.unlock();
-            problem_mtx.lock();
-            problemPages.insert(page->pagePath);
-            problem_mtx.unlock();
+            results->problem.push_back(page->pagePath);
             continue;
         }
 
         //gets path of pages information from last time page was built
         Path pageInfoPath = page->pagePath.getInfoPath();
 
-        //checks whether info path exists
-        if(!std::ifstream(pageInfoPath.str()))
-        {
-            os_mtx.lock();
-            os << page->pagePath << ": yet to be built" << std::endl;
-            os_mtx.unlock();
-            updated_mtx.lock();
-            updatedPages.insert(*page);
-            updated_mtx.unlock();
-            continue;
+        //checks whether info path exists, pages in the build state don't have one
+        const DepIndexEntry* indexEntry = depIndex->buildState ? depIndex->find(page->pageName) : NULL;
+        std::pair<long long int, long long int> infoStamp;
+        if(indexEntry)
+            infoStamp = indexEntry->infoStamp;
+        else
+        {
+            infoStamp = statCache.stamp(pageInfoPath.str());
+            if(!depIndex->buildState)
+                indexEntry = depIndex->find(page->pageName, infoStamp);
+        }
+        Path dep;
+        DepIndexEntry entry;
+        const std::vector<Path>* recordedDeps = NULL; //dependencies from the last build, for pages not yet found to need building
+        if(infoStamp.second < 0)
+        {
+            os_mtx.lock();
+            os << page->pagePath << ": yet to be built" << std::endl;
+            os_mtx.unlock();
+            results->updated.push_back(*page);
+            continue;
+        }
+        else if(indexEntry)
+        {
+            //dependency index entry matches the info file, so it doesn't need opening
+            if(page->pageTitle != indexEntry->pageTitle)
+            {
+                os_mtx.lock();
+                os << page->pagePath << ": title changed to " << page->pageTitle << " from " << indexEntry->pageTitle << std::endl;
+                os_mtx.unlock();
+                results->updated.push_back(*page);
+                continue;
+            }
+
+            if(page->templatePath != indexEntry->templatePath)
+            {
+                os_mtx.lock();
+                os << page->pagePath << ": template path changed to " << page->templatePath << " from " << indexEntry->templatePath << std::endl;
+                os_mtx.unlock();
+                results->updated.push_back(*page);
+                continue;
+            }
+
+            //pages linked to with @pathto/@pathtopage which have moved (eg. new page extension) or are no longer tracked
+            bool refChanged = 0;
+            PageInfo targetPageInfo;
+            for(auto ref=indexEntry->pageRefs.begin(); ref!=indexEntry->pageRefs.end(); ref++)
+            {
+                targetPageInfo.pageName = ref->first;
+                auto target = trackedPages->find(targetPageInfo);
+                if(target == trackedPages->end())
+                {
+                    os_mtx.lock();
+                    os << page->pagePath << ": linked page " << quote(ref->first) << " no longer tracked" << std::endl;
+                    os_mtx.unlock();
+                    refChanged = 1;
+                    break;
+                }
+                else if(target->pagePath != ref->second)
+                {
+                    os_mtx.lock();
+                    os << page->pagePath << ": linked page " << quote(ref->first) << " moved to " << target->pagePath << " from " << ref->second << std::endl;
+                    os_mtx.unlock();
+                    refChanged = 1;
+                    break;
+                }
+            }
+            if(refChanged)
+            {
+                results->updated.push_back(*page);
+                continue;
+            }
+
+            //config keys read by the page (eg. with @sitedir) which have changed
+            bool configChanged = 0;
+            for(auto key=indexEntry->configDeps.begin(); key!=indexEntry->configDeps.end(); key++)
+            {
+                auto value = configValues->find(key->first);
+                std::string newValue = (value == configValues->end()) ? "" : value->second;
+                if(newValue != key->second)
+                {
+                    os_mtx.lock();
+                    os << page->pagePath << ": config " << key->first << " changed to " << quote(newValue) << " from " << quote(key->second) << std::endl;
+                    os_mtx.unlock();
+                    configChanged = 1;
+                    break;
+                }
+            }
+            if(configChanged)
+            {
+                results->updated.push_back(*page);
+                continue;
+            }
+
+            auto dirtyPage = dirtyPages->find(page->pageName);
+            if(dirtyPage != dirtyPages->end())
+            {
+                dep = dirtyPage->second.first;
+                if(dirtyPage->second.second)
+                {
+                    os_mtx.lock();
+                    os << page->pagePath << ": dep path " << dep << " removed since last build" << std::endl;
+                    os_mtx.unlock();
+                    results->removed.push_back(dep);
+                }
+                else
+                {
+                    os_mtx.lock();
+                    os << page->pagePath << ": dep path " << dep << " modified since last build" << std::endl;
+                    os_mtx.unlock();
+                    results->modified.push_back(dep);
+                }
+                results->updated.push_back(*page);
+            }
+            else
+                recordedDeps = &indexEntry->deps;
         }
         else
         {
@@ -1793,9 +2942,7 @@ void dep_thread(std::ostream& os, const int& no_pages, const Directory& contentD
                 os_mtx.lock();
                 os << page->pagePath << ": page name changed to " << page->pageName << " from " << prevPageInfo.pageName << std::endl;
                 os_mtx.unlock();
-                updated_mtx.lock();
-                updatedPages.insert(*page);
-                updated_mtx.unlock();
+                results->updated.push_back(*page);
                 continue;
             }
 
@@ -1804,9 +2951,7 @@ void dep_thread(std::ostream& os, const int& no_pages, const Directory& contentD
                 os_mtx.lock();
                 os << page->pagePath << ": title changed to " << page->pageTitle << " from " << prevPageInfo.pageTitle << std::endl;
                 os_mtx.unlock();
-                updated_mtx.lock();
-                updatedPages.insert(*page);
-                updated_mtx.unlock();
+                results->updated.push_back(*page);
                 continue;
             }
 
@@ -1815,86 +2960,136 @@ void dep_thread(std::ostream& os, const int& no_pages, const Directory& contentD
                 os_mtx.lock();
                 os << page->pagePath << ": template path changed to " << page->templatePath << " from " << prevPageInfo.templatePath << std::endl;
                 os_mtx.unlock();
-                updated_mtx.lock();
-                updatedPages.insert(*page);
-                updated_mtx.unlock();
+                results->updated.push_back(*page);
                 continue;
             }
 
-            Path dep;
+            bool depsChanged = 0;
             while(dep.read_file_path_from(infoStream))
             {
-                if(!std::ifstream(dep.str()))
+                if(!statCache.exists(dep.str()))
                 {
                     os_mtx.lock();
                     os << page->pagePath << ": dep path " << dep << " removed since last build" << std::endl;
                     os_mtx.unlock();
-                    removed_mtx.lock();
-                    removedFiles.insert(dep);
-                    removed_mtx.unlock();
-                    updated_mtx.lock();
-                    updatedPages.insert(*page);
-                    updated_mtx.unlock();
+                    results->removed.push_back(dep);
+                    results->updated.push_back(*page);
+                    depsChanged = 1;
                     break;
                 }
-                else if(dep.modified_after(pageInfoPath))
+                else if(statCache.modified_after(dep, pageInfoPath))
                 {
                     os_mtx.lock();
                     os << page->pagePath << ": dep path " << dep << " modified since last build" << std::endl;
                     os_mtx.unlock();
-                    modified_mtx.lock();
-                    modifiedFiles.insert(dep);
-                    modified_mtx.unlock();
-                    updated_mtx.lock();
-                    updatedPages.insert(*page);
-                    updated_mtx.unlock();
+                    results->modified.push_back(dep);
+                    results->updated.push_back(*page);
+                    depsChanged = 1;
                     break;
                 }
+                entry.deps.push_back(dep);
             }
 
 			infoStream.close();
 
-            //checks for user-defined dependencies
-            Path depsPath = page->contentPath;
-            depsPath.file = depsPath.file.substr(0, depsPath.file.find_first_of('.')) + ".deps";
+            //adds up to date page to the dependency index so its info file needn't be opened next time
+            if(!depsChanged)
+            {
+                entry.infoStamp = infoStamp;
+                entry.pageTitle = prevPageInfo.pageTitle;
+                entry.templatePath = prevPageInfo.templatePath;
+                depIndex->stamp_deps(entry, 1);
+                results->indexed.push_back(std::make_pair(page->pageName, entry));
+                recordedDeps = &entry.deps;
+            }
+        }
+
+        //checks for a .deps file the last build didn't record
+        Path depsPath;
+        if(recordedDeps && unrecorded_deps_file(*page, *recordedDeps, depsPath))
+        {
+            os_mtx.lock();
+            os << page->pagePath << ": user defined deps file " << depsPath << " not recorded at last build" << std::endl;
+            os_mtx.unlock();
+            results->modified.push_back(depsPath);
+            results->updated.push_back(*page);
+        }
+    }
+}
+
+//works out which indexed pages have modified or removed dependencies, checking each dependency once
+void find_dirty_pages(DepIndex& depIndex, DirtyPages& dirtyPages, const bool& reportOnly)
+{
+    std::pair<long long int, long long int> depStamp;
+
+    dirtyPages.clear();
+    for(auto dep=depIndex.reverse.begin(); dep!=depIndex.reverse.end(); dep++)
+    {
+        depStamp = statCache.stamp(dep->first.str());
+
+        for(auto slot=dep->second.begin(); slot!=dep->second.end(); slot++)
+        {
+            const Name& pageName = slot->page->first;
+            if(dirtyPages.count(pageName))
+                continue;
+
+            DepIndexEntry& entry = slot->page->second;
 
-            if(std::ifstream(depsPath.str()))
+            if(depStamp.second < 0)
+                dirtyPages[pageName] = std::make_pair(dep->first, true);
+            else if(depIndex.dep_changed(entry, slot->d, depStamp))
+                dirtyPages[pageName] = std::make_pair(dep->first, false);
+            else if(!reportOnly && depStamp != entry.depStamps[slot->d].stamp)
             {
-                std::ifstream depsFile(depsPath.str());
-                while(dep.read_file_path_from(depsFile))
-                {
-                    if(!std::ifstream(dep.str()))
-                    {
-                        os_mtx.lock();
-                        os << page->pagePath << ": user defined dep path " << dep << " does not exist" << std::endl;
-                        os_mtx.unlock();
-                        removed_mtx.lock();
-                        removedFiles.insert(dep);
-                        removed_mtx.unlock();
-                        updated_mtx.lock();
-                        updatedPages.insert(*page);
-                        updated_mtx.unlock();
-                        break;
-                    }
-                    else if(dep.modified_after(pageInfoPath))
-                    {
-                        os_mtx.lock();
-                        os << page->pagePath << ": user defined dep path " << dep << " modified since last build" << std::endl;
-                        os_mtx.unlock();
-                        modified_mtx.lock();
-                        modifiedFiles.insert(dep);
-                        modified_mtx.unlock();
-                        updated_mtx.lock();
-                        updatedPages.insert(*page);
-                        updated_mtx.unlock();
-                        break;
-                    }
-                }
+                //contents are unchanged, new stamp is saved so the dependency isn't hashed again
+                entry.depStamps[slot->d].stamp = depStamp;
+                depIndex.updatedPages.insert(pageName);
             }
         }
     }
 }
 
+//works out which pages need building using no_threads dep threads, filling updatedPages, modifiedFiles, removedFiles and problemPages
+//reportOnly leaves the dependency index as it is (eg. for status), otherwise new stamps of unchanged dependencies and entries for pages missing from it are recorded
+void check_pages(std::ostream& os, const int& no_threads, PageSet& pagesToCheck, const PageSet& trackedPages, const std::map<std::string, std::string>& configValues, DepIndex& depIndex, const bool& reportOnly, const Directory& contentDir, const Directory& siteDir, const std::string& contentExt, const std::string& pageExt)
+{
+    DirtyPages dirtyPages;
+    depIndex.open();
+    find_dirty_pages(depIndex, dirtyPages, reportOnly);
+
+    cPage = pagesToCheck.begin();
+    counter = 0;
+
+    std::vector<DepResults> threadResults(no_threads);
+
+	std::vector<std::thread> threads;
+	for(int i=0; i<no_threads; i++)
+		threads.push_back(std::thread(dep_thread, std::ref(os), pagesToCheck.size(), &threadResults[i], &trackedPages, &configValues, &depIndex, &dirtyPages, contentDir, siteDir, contentExt, pageExt));
+
+	for(int i=0; i<no_threads; i++)
+		threads[i].join();
+
+    //merges the per-thread results now that no other thread is writing to them
+    std::vector<std::vector<PageInfo> > threadUpdated(no_threads);
+    std::vector<std::vector<Path> > threadModified(no_threads), threadRemoved(no_threads), threadProblem(no_threads);
+    for(int i=0; i<no_threads; i++)
+    {
+        threadUpdated[i].swap(threadResults[i].updated);
+        threadModified[i].swap(threadResults[i].modified);
+        threadRemoved[i].swap(threadResults[i].removed);
+        threadProblem[i].swap(threadResults[i].problem);
+    }
+    merge_results(threadModified, modifiedFiles);
+    merge_results(threadRemoved, removedFiles);
+    merge_results(threadProblem, problemPages);
+    for(int i=0; i<no_threads; i++)
+        for(size_t p=0; p<threadUpdated[i].size(); p++)
+            updatedPages.insert(threadUpdated[i][p]);
+    for(int i=0; reportOnly==0 && i<no_threads; i++)
+        for(size_t p=0; p<threadResults[i].indexed.size(); p++)
+            depIndex.update(threadResults[i].indexed[p].first, threadResults[i].indexed[p].second);
+}
+
 int SiteInfo::build_updated(std::ostream& os)
 {
     builtPages.clear();
@@ -1904,27 +3099,40 @@ int SiteInfo::build_updated(std::ostream& os)
     modifiedFiles.clear();
     removedFiles.clear();
 
-    int no_threads;
-    if(buildThreads < 0)
-        no_threads = -buildThreads*std::thread::hardware_concurrency();
-    else
-        no_threads = buildThreads;
+    //files are stat'ed afresh each build pass (the daemon keeps running between them)
+    statCache.clear();
 
-    cPage = pages.begin();
-    counter = 0;
+    int no_threads, no_build_thrds;
+    get_no_threads(no_threads, no_build_thrds);
 
-	std::vector<std::thread> threads;
-	for(int i=0; i<no_threads; i++)
-		threads.push_back(std::thread(dep_thread, std::ref(os), pages.size(), contentDir, siteDir, contentExt, pageExt));
+    DateTimeInfo buildDateTime;
+    bool depsBuildTime;
+    if(get_build_time(buildDateTime, depsBuildTime))
+        return 1;
 
-	for(int i=0; i<no_threads; i++)
-		threads[i].join();
+    //when sharding only this shard's pages are checked and built
+    PageSet shardPages;
+    PageSet* pagesToCheck = &pages;
+    if(noShards > 1)
+    {
+        get_shard_pages(shardPages);
+        pagesToCheck = &shardPages;
+        os << "checking shard " << shardNo << "/" << noShards << ": " << shardPages.size() << " of " << pages.size() << " pages" << std::endl;
+    }
+
+    std::map<std::string, std::string> configValues;
+    get_config_values(configValues);
+
+    depIndex.hashDeps = hashDeps;
+    depIndex.buildState = buildState;
+    depIndex.reverseIndex = 1;
+    check_pages(os, no_threads, *pagesToCheck, pages, configValues, depIndex, dryRun, contentDir, siteDir, contentExt, pageExt);
 
     if(removedFiles.size() > 0)
     {
         os << std::endl;
         os << "---- removed dependency files ----" << std::endl;
-        if(removedFiles.size() < 20)
+        if(dryRun || removedFiles.size() < 20)
             for(auto rFile=removedFiles.begin(); rFile != removedFiles.end(); rFile++)
                 os << " " << *rFile << std::endl;
         else
@@ -1941,7 +3149,7 @@ int SiteInfo::build_updated(std::ostream& os)
     {
         os << std::endl;
         os << "------- updated dependency files ------" << std::endl;
-        if(modifiedFiles.size() < 20)
+        if(dryRun || modifiedFiles.size() < 20)
             for(auto uFile=modifiedFiles.begin(); uFile != modifiedFiles.end(); uFile++)
                 os << " " << *uFile << std::endl;
         else
@@ -1958,7 +3166,7 @@ int SiteInfo::build_updated(std::ostream& os)
     {
         os << std::endl;
         os << "----- pages that need building -----" << std::endl;
-        if(updatedPages.size() < 20)
+        if(dryRun || updatedPages.size() < 20)
             for(auto uPage=updatedPages.begin(); uPage != updatedPages.end(); uPage++)
                 os << " " << uPage->pagePath << std::endl;
         else
@@ -1975,7 +3183,7 @@ int SiteInfo::build_updated(std::ostream& os)
     {
         os << std::endl;
         os << "----- pages with missing content or template file -----" << std::endl;
-        if(problemPages.size() < 20)
+        if(dryRun || problemPages.size() < 20)
             for(auto pPage=problemPages.begin(); pPage != problemPages.end(); pPage++)
                 os << " " << *pPage << std::endl;
         else
@@ -1988,15 +3196,29 @@ int SiteInfo::build_updated(std::ostream& os)
         os << "-------------------------------------------------------" << std::endl;
     }
 
+    //leaves the pages and the dependency index as they are
+    if(dryRun)
+    {
+        os << std::endl;
+        if(updatedPages.size() == 0 && problemPages.size() == 0)
+            os << "all pages are already up to date" << std::endl;
+        else
+            os << "dry run: " << updatedPages.size() << (updatedPages.size() == 1 ? " page" : " pages") << " would be built" << std::endl;
+        return 0;
+    }
+
     cPage = updatedPages.begin();
     counter = 0;
 
-	threads.clear();
-	for(int i=0; i<no_threads; i++)
-		threads.push_back(std::thread(build_thread, std::ref(os), &pages, updatedPages.size(), contentDir, siteDir, contentExt, pageExt, scriptExt, defaultTemplate, unixTextEditor, winTextEditor));
+    run_build_threads(os, no_build_thrds, autoBuildThreads, &pages, updatedPages.size(), contentDir, siteDir, contentExt, pageExt, scriptExt, defaultTemplate, unixTextEditor, winTextEditor, parallelInputs, buildDateTime, depsBuildTime, &depIndex, NULL);
+    if(autoBuildThreads && updatedPages.size())
+        os << "auto build threads: settled on " << activeThreads << " threads" << std::endl;
 
-	for(int i=0; i<no_threads; i++)
-		threads[i].join();
+    depIndex.save(&pages);
+
+    int summaryFailed = 0;
+    if(noShards > 1)
+        summaryFailed = save_shard_summary("build-updated");
 
     if(builtPages.size() > 0)
     {
@@ -2015,6 +3237,23 @@ int SiteInfo::build_updated(std::ostream& os)
         os << "----------------------------------------" << std::endl;
     }
 
+    if(unchangedPages.size() > 0)
+    {
+        os << std::endl;
+        os << "---- built pages with unchanged output ----" << std::endl;
+        if(unchangedPages.size() < 20)
+            for(auto uName=unchangedPages.begin(); uName != unchangedPages.end(); uName++)
+                os << " " << *uName << std::endl;
+        else
+        {
+            int x=0;
+            for(auto uName=unchangedPages.begin(); x < 20; uName++, x++)
+                os << " " << *uName << std::endl;
+            os << " along with " << unchangedPages.size() - 20 << " other pages" << std::endl;
+        }
+        os << "-------------------------------------------" << std::endl;
+    }
+
     if(failedPages.size() > 0)
     {
         os << std::endl;
@@ -2041,7 +3280,7 @@ int SiteInfo::build_updated(std::ostream& os)
 	builtPages.clear();
 	failedPages.clear();
 
-    return 0;
+    return summaryFailed;
 }
 
 int SiteInfo::status()
@@ -2053,108 +3292,42 @@ int SiteInfo::status()
         return 0;
     }
 
-    std::set<Path> updatedFiles, removedFiles;
-    std::set<PageInfo> updatedPages, problemPages;
-
-    for(auto page=pages.begin(); page != pages.end(); page++)
-    {
-        bool needsUpdating = 0;
-
-        //checks whether content and template files exist
-        if(!std::ifstream(page->contentPath.str()))
-        {
-            needsUpdating = 1; //shouldn't need this but doesn't cost much
-            problemPages.insert(*page);
-            //note user will be informed about this as a dep not existing
-        }
-        if(!std::ifstream(page->templatePath.str()))
-        {
-            needsUpdating = 1; //shouldn't need this but doesn't cost much
-            problemPages.insert(*page);
-            //note user will be informed about this as a dep not existing
-        }
-
-        //gets path of pages information from last time page was built
-        Path pageInfoPath = page->pagePath.getInfoPath();
-
-        //checks whether info path exists
-        if(!std::ifstream(pageInfoPath.str()))
-        {
-            std::cout << page->pagePath << ": yet to be built" << std::endl;
-            needsUpdating = 1;
-        }
-        else
-        {
-            std::ifstream infoStream(pageInfoPath.str());
-            std::string timeDateLine;
-            Name prevName;
-            Title prevTitle;
-            Path prevTemplatePath;
-
-            getline(infoStream, timeDateLine);
-            read_quoted(infoStream, prevName);
-            prevTitle.read_quoted_from(infoStream);
-            prevTemplatePath.read_file_path_from(infoStream);
-
-            //probably don't even need this
-            PageInfo prevPageInfo = make_info(prevName, prevTitle, prevTemplatePath);
-
-            if(page->pageName != prevPageInfo.pageName)
-            {
-                std::cout << page->pagePath << ": page name changed to " << page->pageName << " from " << prevPageInfo.pageName << std::endl;
-                needsUpdating = 1;
-            }
-
-            if(page->pageTitle != prevPageInfo.pageTitle)
-            {
-                std::cout << page->pagePath << ": title changed to " << page->pageTitle << " from " << prevPageInfo.pageTitle << std::endl;
-                needsUpdating = 1;
-            }
+    problemPages.clear();
+    updatedPages.clear();
+    modifiedFiles.clear();
+    removedFiles.clear();
 
-            if(page->templatePath != prevPageInfo.templatePath)
-            {
-                std::cout << page->pagePath << ": template path changed to " << page->templatePath << " from " << prevPageInfo.templatePath << std::endl;
-                needsUpdating = 1;
-            }
+    statCache.clear();
 
-            Path dep;
-            while(dep.read_file_path_from(infoStream))
-            {
-                if(!std::ifstream(dep.str()))
-                {
-                    removedFiles.insert(dep);
-                    needsUpdating = 1;
-                }
-                else if(dep.modified_after(pageInfoPath))
-                {
-                    updatedFiles.insert(dep);
-                    needsUpdating = 1;
-                }
-            }
+    int no_threads, no_build_thrds;
+    get_no_threads(no_threads, no_build_thrds);
 
-			infoStream.close();
-        }
+    std::map<std::string, std::string> configValues;
+    get_config_values(configValues);
 
-        if(needsUpdating && problemPages.count(*page) == 0)
-            updatedPages.insert(*page);
-    }
+    //checks pages the same way build-updated does
+    depIndex.hashDeps = hashDeps;
+    depIndex.buildState = buildState;
+    depIndex.reverseIndex = 1;
+    //leaves the dependency index as it is, status doesn't change anything
+    check_pages(std::cout, no_threads, pages, pages, configValues, depIndex, 1, contentDir, siteDir, contentExt, pageExt);
 
     if(removedFiles.size() > 0)
     {
         std::cout << std::endl;
-        std::cout << "---- removed content files ----" << std::endl;
+        std::cout << "---- removed dependency files ----" << std::endl;
         for(auto rFile=removedFiles.begin(); rFile != removedFiles.end(); rFile++)
             std::cout << *rFile << std::endl;
-        std::cout << "-------------------------------" << std::endl;
+        std::cout << "----------------------------------" << std::endl;
     }
 
-    if(updatedFiles.size() > 0)
+    if(modifiedFiles.size() > 0)
     {
         std::cout << std::endl;
-        std::cout << "------- updated content files ------" << std::endl;
-        for(auto uFile=updatedFiles.begin(); uFile != updatedFiles.end(); uFile++)
+        std::cout << "------- updated dependency files ------" << std::endl;
+        for(auto uFile=modifiedFiles.begin(); uFile != modifiedFiles.end(); uFile++)
             std::cout << *uFile << std::endl;
-        std::cout << "------------------------------------" << std::endl;
+        std::cout << "---------------------------------------" << std::endl;
     }
 
     if(updatedPages.size() > 0)
@@ -2170,12 +3343,12 @@ int SiteInfo::status()
     {
         std::cout << std::endl;
         std::cout << "----- pages with missing content or template file -----" << std::endl;
-        for(auto uPage=problemPages.begin(); uPage != problemPages.end(); uPage++)
-            std::cout << uPage->pagePath << std::endl;
+        for(auto pPage=problemPages.begin(); pPage != problemPages.end(); pPage++)
+            std::cout << *pPage << std::endl;
         std::cout << "-------------------------------------------------------" << std::endl;
     }
 
-    if(updatedFiles.size() == 0 && updatedPages.size() == 0 && problemPages.size() == 0)
+    if(modifiedFiles.size() == 0 && updatedPages.size() == 0 && problemPages.size() == 0)
     {
         std::cout << std::endl;
         std::cout << "all pages are already up to date" << std::endl;
@@ -2183,3 +3356,354 @@ int SiteInfo::status()
 
     return 0;
 }
+
+//a reason a page needs building, for explain
+struct BuildReason
+{
+    std::string type, //eg. "modified", "title", "config"
+                subject, //dependency, linked page or config key the reason is about
+                message, //as build-updated would describe it
+                was, now; //eg. old and new titles
+    bool stamped; //whether the dependency's stamps below are known
+    DepStamp wasStamp, nowStamp;
+    std::vector<Path> chain; //files through which the page depends on subject, starting from its template
+
+    BuildReason(const std::string& Type, const std::string& Subject, const std::string& Message)
+    {
+        type = Type;
+        subject = Subject;
+        message = Message;
+        stamped = 0;
+    }
+};
+
+std::string json_quote(const std::string& str)
+{
+    std::ostringstream oss;
+    oss << "\"";
+    for(size_t i=0; i<str.size(); i++)
+    {
+        if(str[i] == '"' || str[i] == '\\')
+            oss << "\\" << str[i];
+        else if(str[i] == '\n')
+            oss << "\\n";
+        else if(str[i] == '\t')
+            oss << "\\t";
+        else if((unsigned char)str[i] < 0x20)
+        {
+            char buf[8];
+            snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)str[i]);
+            oss << buf;
+        }
+        else
+            oss << str[i];
+    }
+    oss << "\"";
+
+    return oss.str();
+}
+
+//size, modification time and hash of a dependency, eg. 34 bytes, modified 2020-01-01 10:00:00.000000000
+std::string stamp_str(const DepStamp& depStamp)
+{
+    std::ostringstream oss;
+    time_t seconds = depStamp.stamp.second/1000000000;
+    char buf[80], ns[16];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", localtime(&seconds));
+    snprintf(ns, sizeof(ns), ".%09lld", depStamp.stamp.second%1000000000);
+
+    oss << depStamp.stamp.first << " bytes, modified " << buf << ns;
+    if(depStamp.hash)
+        oss << ", hash " << std::hex << depStamp.hash;
+
+    return oss.str();
+}
+
+std::string stamp_json(const DepStamp& depStamp)
+{
+    std::ostringstream oss;
+    oss << "{\"size\": " << depStamp.stamp.first << ", \"mtime\": " << depStamp.stamp.second;
+    if(depStamp.hash)
+        oss << ", \"hash\": \"" << std::hex << depStamp.hash << "\"";
+    oss << "}";
+
+    return oss.str();
+}
+
+//lists every reason a page needs building (build-updated stops at the first), with how each
+//dependency was when the page was last built, how it is now and how the page comes to depend on it
+int SiteInfo::explain(const Name& pageName, const bool& json)
+{
+    if(!tracking(pageName))
+    {
+        std::cout << "error: Nift is not tracking " << quote(pageName) << std::endl;
+        return 1;
+    }
+
+    PageInfo page = get_info(pageName);
+    std::vector<BuildReason> reasons;
+    std::ostringstream oss;
+
+    statCache.clear();
+
+    std::map<std::string, std::string> configValues;
+    get_config_values(configValues);
+
+    //the resident dependency index is shared with builds in the daemon, so its flags are put back afterwards
+    bool prevHashDeps = depIndex.hashDeps, prevBuildState = depIndex.buildState, prevReverseIndex = depIndex.reverseIndex;
+    depIndex.hashDeps = hashDeps;
+    depIndex.buildState = buildState;
+    depIndex.reverseIndex = 0;
+    depIndex.open();
+    bool mtimeOnly = 0;
+
+    //checks whether content and template files exist
+    if(!statCache.exists(page.contentPath.str()))
+    {
+        oss.str("");
+        oss << "content file " << page.contentPath << " does not exist";
+        reasons.push_back(BuildReason("missing", page.contentPath.str(), oss.str()));
+    }
+    if(!statCache.exists(page.templatePath.str()))
+    {
+        oss.str("");
+        oss << "template file " << page.templatePath << " does not exist";
+        reasons.push_back(BuildReason("missing", page.templatePath.str(), oss.str()));
+    }
+
+    Path pageInfoPath = page.pagePath.getInfoPath();
+    const DepIndexEntry* indexEntry = buildState ? depIndex.find(page.pageName) : NULL;
+    std::pair<long long int, long long int> infoStamp;
+    if(indexEntry)
+        infoStamp = indexEntry->infoStamp;
+    else
+    {
+        infoStamp = statCache.stamp(pageInfoPath.str());
+        if(!buildState)
+            indexEntry = depIndex.find(page.pageName, infoStamp);
+    }
+
+    std::vector<Path> recordedDeps;
+    if(infoStamp.second < 0)
+        reasons.push_back(BuildReason("unbuilt", page.pageName, "yet to be built"));
+    else if(indexEntry)
+    {
+        recordedDeps = indexEntry->deps;
+
+        if(page.pageTitle != indexEntry->pageTitle)
+        {
+            oss.str("");
+            oss << "title changed to " << page.pageTitle << " from " << indexEntry->pageTitle;
+            reasons.push_back(BuildReason("title", page.pageName, oss.str()));
+            reasons.back().was = indexEntry->pageTitle.str;
+            reasons.back().now = page.pageTitle.str;
+        }
+
+        if(page.templatePath != indexEntry->templatePath)
+        {
+            oss.str("");
+            oss << "template path changed to " << page.templatePath << " from " << indexEntry->templatePath;
+            reasons.push_back(BuildReason("template", page.pageName, oss.str()));
+            reasons.back().was = indexEntry->templatePath.str();
+            reasons.back().now = page.templatePath.str();
+        }
+
+        PageInfo targetPageInfo;
+        for(auto ref=indexEntry->pageRefs.begin(); ref!=indexEntry->pageRefs.end(); ref++)
+        {
+            targetPageInfo.pageName = ref->first;
+            auto target = pages.find(targetPageInfo);
+            if(target == pages.end())
+            {
+                oss.str("");
+                oss << "linked page " << quote(ref->first) << " no longer tracked";
+                reasons.push_back(BuildReason("linked page", ref->first, oss.str()));
+                reasons.back().was = ref->second.str();
+            }
+            else if(target->pagePath != ref->second)
+            {
+                oss.str("");
+                oss << "linked page " << quote(ref->first) << " moved to " << target->pagePath << " from " << ref->second;
+                reasons.push_back(BuildReason("linked page", ref->first, oss.str()));
+                reasons.back().was = ref->second.str();
+                reasons.back().now = target->pagePath.str();
+            }
+        }
+
+        for(auto key=indexEntry->configDeps.begin(); key!=indexEntry->configDeps.end(); key++)
+        {
+            std::string newValue = configValues.count(key->first) ? configValues[key->first] : "";
+            if(newValue != key->second)
+            {
+                oss.str("");
+                oss << "config " << key->first << " changed to " << quote(newValue) << " from " << quote(key->second);
+                reasons.push_back(BuildReason("config", key->first, oss.str()));
+                reasons.back().was = key->second;
+                reasons.back().now = newValue;
+            }
+        }
+
+        for(size_t d=0; d<indexEntry->deps.size(); d++)
+        {
+            DepStamp nowStamp;
+            nowStamp.stamp = statCache.stamp(indexEntry->deps[d].str());
+            nowStamp.hash = 0;
+
+            oss.str("");
+            if(nowStamp.stamp.second < 0)
+            {
+                oss << "dep path " << indexEntry->deps[d] << " removed since last build";
+                reasons.push_back(BuildReason("removed", indexEntry->deps[d].str(), oss.str()));
+            }
+            else if(depIndex.dep_changed(*indexEntry, d, nowStamp.stamp))
+            {
+                if(hashDeps && indexEntry->depStamps[d].hash)
+                    nowStamp.hash = statCache.hash(indexEntry->deps[d].str(), nowStamp.stamp);
+                oss << "dep path " << indexEntry->deps[d] << " modified since last build";
+                reasons.push_back(BuildReason("modified", indexEntry->deps[d].str(), oss.str()));
+            }
+            else
+                continue;
+
+            BuildReason& reason = reasons.back();
+            reason.stamped = 1;
+            reason.wasStamp = indexEntry->depStamps[d];
+            reason.nowStamp = nowStamp;
+
+            //follows the files each dependency was read from back to the template
+            for(int p=d, steps=0; p >= 0 && p < (int)indexEntry->deps.size() && steps <= (int)indexEntry->deps.size(); steps++)
+            {
+                reason.chain.insert(reason.chain.begin(), indexEntry->deps[p]);
+                p = (p < (int)indexEntry->depParents.size()) ? indexEntry->depParents[p] : -1;
+            }
+        }
+    }
+    else
+    {
+        //pages missing from the dependency index are checked against their info files, which don't record hashes
+        mtimeOnly = hashDeps;
+        std::ifstream infoStream(pageInfoPath.str());
+        std::string timeDateLine;
+        Name prevName;
+        Title prevTitle;
+        Path prevTemplatePath, dep;
+
+        getline(infoStream, timeDateLine);
+        read_quoted(infoStream, prevName);
+        prevTitle.read_quoted_from(infoStream);
+        prevTemplatePath.read_file_path_from(infoStream);
+
+        if(page.pageTitle != prevTitle)
+        {
+            oss.str("");
+            oss << "title changed to " << page.pageTitle << " from " << prevTitle;
+            reasons.push_back(BuildReason("title", page.pageName, oss.str()));
+            reasons.back().was = prevTitle.str;
+            reasons.back().now = page.pageTitle.str;
+        }
+
+        if(page.templatePath != prevTemplatePath)
+        {
+            oss.str("");
+            oss << "template path changed to " << page.templatePath << " from " << prevTemplatePath;
+            reasons.push_back(BuildReason("template", page.pageName, oss.str()));
+            reasons.back().was = prevTemplatePath.str();
+            reasons.back().now = page.templatePath.str();
+        }
+
+        while(dep.read_file_path_from(infoStream))
+        {
+            recordedDeps.push_back(dep);
+            oss.str("");
+            if(!statCache.exists(dep.str()))
+            {
+                oss << "dep path " << dep << " removed since last build";
+                reasons.push_back(BuildReason("removed", dep.str(), oss.str()));
+            }
+            else if(statCache.modified_after(dep, pageInfoPath))
+            {
+                oss << "dep path " << dep << " modified since last build";
+                reasons.push_back(BuildReason("modified", dep.str(), oss.str()));
+            }
+        }
+
+        infoStream.close();
+    }
+
+    //checks for a .deps file the last build didn't record
+    Path depsPath;
+    if(infoStamp.second >= 0 && unrecorded_deps_file(page, recordedDeps, depsPath))
+    {
+        oss.str("");
+        oss << "user defined deps file " << depsPath << " not recorded at last build";
+        reasons.push_back(BuildReason("modified", depsPath.str(), oss.str()));
+        reasons.back().chain.push_back(page.contentPath);
+        reasons.back().chain.push_back(depsPath);
+    }
+
+    if(json)
+    {
+        std::cout << "{" << std::endl;
+        std::cout << "    \"page\": " << json_quote(page.pageName) << "," << std::endl;
+        std::cout << "    \"pagePath\": " << json_quote(page.pagePath.str()) << "," << std::endl;
+        std::cout << "    \"upToDate\": " << (reasons.size() ? "false" : "true") << "," << std::endl;
+        std::cout << "    \"mtimeOnly\": " << (mtimeOnly ? "true" : "false") << "," << std::endl;
+        std::cout << "    \"reasons\": [";
+        for(size_t r=0; r<reasons.size(); r++)
+        {
+            std::cout << (r ? "," : "") << std::endl;
+            std::cout << "        {\"reason\": " << json_quote(reasons[r].type);
+            std::cout << ", \"subject\": " << json_quote(reasons[r].subject);
+            std::cout << ", \"message\": " << json_quote(reasons[r].message);
+            if(reasons[r].stamped)
+            {
+                std::cout << ", \"was\": " << stamp_json(reasons[r].wasStamp);
+                if(reasons[r].type != "removed")
+                    std::cout << ", \"now\": " << stamp_json(reasons[r].nowStamp);
+            }
+            else if(reasons[r].was != "" || reasons[r].now != "")
+                std::cout << ", \"was\": " << json_quote(reasons[r].was) << ", \"now\": " << json_quote(reasons[r].now);
+            if(reasons[r].chain.size())
+            {
+                std::cout << ", \"chain\": [";
+                for(size_t c=0; c<reasons[r].chain.size(); c++)
+                    std::cout << (c ? ", " : "") << json_quote(reasons[r].chain[c].str());
+                std::cout << "]";
+            }
+            std::cout << "}";
+        }
+        std::cout << (reasons.size() ? "\n    " : "") << "]" << std::endl;
+        std::cout << "}" << std::endl;
+    }
+    else if(reasons.size())
+    {
+        std::cout << page.pagePath << " needs building:" << std::endl;
+        for(size_t r=0; r<reasons.size(); r++)
+        {
+            std::cout << " " << reasons[r].message << std::endl;
+            if(reasons[r].stamped)
+            {
+                std::cout << "   was: " << stamp_str(reasons[r].wasStamp) << std::endl;
+                if(reasons[r].type != "removed")
+                    std::cout << "   now: " << stamp_str(reasons[r].nowStamp) << std::endl;
+            }
+            if(reasons[r].chain.size() > 1)
+            {
+                std::cout << "   via:";
+                for(size_t c=0; c<reasons[r].chain.size(); c++)
+                    std::cout << (c ? " > " : " ") << reasons[r].chain[c];
+                std::cout << std::endl;
+            }
+        }
+    }
+    else
+        std::cout << page.pagePath << " is up to date" << std::endl;
+    if(!json && mtimeOnly)
+        std::cout << "note: " << quote(page.pageName) << " is missing from the dependency index, dependencies were checked by modification time only (without hashes)" << std::endl;
+
+    depIndex.hashDeps = prevHashDeps;
+    depIndex.buildState = prevBuildState;
+    depIndex.reverseIndex = prevReverseIndex;
+
+    return 0;
+}
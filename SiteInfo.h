@@ -1,21 +1,37 @@
 #ifndef SITE_INFO_H_
 #define SITE_INFO_H_
 
+#include <algorithm>
 #include <cmath>
+#include <condition_variable>
 #include <math.h>
 #include <mutex>
 #include <thread>
 
 #include <atomic>
 
+#include "BuildState.h"
 #include "GitInfo.h"
+#include "Hash.h"
 #include "PageBuilder.h"
+#include "PageIndex.h"
+#include "Timer.h"
 
 struct SiteInfo
 {
     Directory contentDir,
               siteDir;
     int buildThreads;
+    bool autoBuildThreads;
+    int parallelInputs;
+    bool hashDeps;
+    bool buildState;
+    int pagesListVersion; //2 once extension overrides are kept in pages.list rather than files beside info files
+    std::string buildTime; //pinned time for build time directives (seconds since the epoch or "deps"), empty for when built
+    int shardNo,
+        noShards;
+    bool shardByCost;
+    bool dryRun; //build-updated lists everything which needs building without building it
     std::string contentExt,
                 pageExt,
                 scriptExt,
@@ -24,13 +40,22 @@ struct SiteInfo
                 rootBranch,
                 siteBranch;
     Path defaultTemplate;
-    std::set<PageInfo> pages;
+    PageSet pages;
+    size_t noJournalRecords; //changes appended to .siteinfo/pages.journal since pages.list was last saved
+    DepIndex depIndex; //stays open between requests to the daemon, only reread when it has changed
 
     int open();
     int open_config();
+    bool read_page_entry(const char *&pos, const char *end, PageInfo& page, std::vector<Path>* extPaths);
     int open_pages();
+    int index_pages();
+    int open_pages(const std::vector<Name>& pageNames);
+    int read_page_names(const std::string& prefix, std::vector<Name>& pageNames);
+    std::ostream& write_page_entry(std::ostream& os, const PageInfo& page);
     int save_pages();
+    int save_page_changes(const std::vector<Name>& removedNames, const std::vector<PageInfo>& updatedPages);
     int save_config();
+    int get_config_values(std::map<std::string, std::string>& configValues);
 
     PageInfo make_info(const Name &pageName);
     PageInfo make_info(const Name &pageName, const Title &pageTitle);
@@ -38,7 +63,7 @@ struct SiteInfo
     PageInfo get_info(const Name &pageName);
     int info(const std::vector<Name> &pageNames);
     int info_all();
-    int info_names();
+    int info_names(const std::string& prefix);
 
     std::string get_ext(const PageInfo& page, const std::string& extType);
     std::string get_cont_ext(const PageInfo& page);
@@ -47,11 +72,24 @@ struct SiteInfo
 
     bool tracking(const PageInfo &page);
     bool tracking(const Name &pageName);
+    int check_track(const PageInfo &newPage);
+    int check_new_files(const PageInfo &newPage);
     int track(const Name &name, const Title &title, const Path &templatePath);
+    int track_many(const std::vector<Name> &names, const std::vector<Title> &titles, const std::vector<Path> &templatePaths);
+    int remove_page_files(const PageInfo &page, const bool &removeContent);
     int untrack(const Name &pageNameToUntrack);
     int rm(const Name &pageNameToRemove);
+    int remove_many(const std::vector<Name> &pageNames, const bool &removeContent);
+    int untrack_many(const std::vector<Name> &pageNames);
+    int rm_many(const std::vector<Name> &pageNames);
+    int check_move(const Name &trackedPageName, const Name &newPageName);
+    PageInfo moved_info(const PageInfo &trackedPageInfo, const Name &newPageName);
+    int copy_content(const PageInfo &trackedPageInfo, const PageInfo &newPageInfo);
     int mv(const Name &oldPageName, const Name &newPageName);
     int cp(const Name &trackedPageName, const Name &newPageName);
+    int move_many(const std::vector<std::pair<Name, Name> > &moves, const bool &removeTracked);
+    int mv_many(const std::vector<std::pair<Name, Name> > &moves);
+    int cp_many(const std::vector<std::pair<Name, Name> > &copies);
 
     int new_title(const Name &pageName, const Title &newTitle);
     int new_template(const Path &newTemplatePath);
@@ -66,12 +104,22 @@ struct SiteInfo
     int new_script_ext(const Name &pageName, const std::string &newExt);
 
     int no_build_threads(int noThreads);
+    int auto_build_threads();
+    int get_no_threads(int& noDepThreads, int& noBuildThreads);
+    int get_build_time(DateTimeInfo& buildDateTime, bool& depsBuildTime);
+
+    int set_shard(const int& ShardNo, const int& NoShards, const bool& byCost);
+    int get_shard_pages(PageSet& shardPages);
+    int save_shard_summary(const std::string& buildType);
+    int merge_shards(const int& NoShards);
 
     int build(const std::vector<Name>& pageNamesToBuild);
     int build_all();
+    int build_all_batched();
     int build_updated(std::ostream& os);
 
     int status();
+    int explain(const Name& pageName, const bool& json);
 };
 
 #endif //SITE_INFO_H_
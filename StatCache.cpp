@@ -0,0 +1,134 @@
+#include "StatCache.h"
+
+StatCache statCache;
+
+StatCache::StatCache()
+{
+    noLookups = noStats = noHashes = 0;
+    cacheContents = 0;
+    maxContentsSize = 256*1024*1024;
+    contentsSize = 0;
+}
+
+//file contents aren't cleared, they're checked against the file's stamp when read
+void StatCache::clear()
+{
+    for(int s=0; s<noShards; s++)
+    {
+        std::lock_guard<std::mutex> lock(mtxs[s]);
+        stamps[s].clear();
+        hashes[s].clear();
+    }
+    noLookups = noStats = noHashes = 0;
+}
+
+std::pair<long long int, long long int> StatCache::stamp(const std::string& path)
+{
+    size_t s = std::hash<std::string>()(path) % noShards;
+
+    noLookups++;
+
+    {
+        std::lock_guard<std::mutex> lock(mtxs[s]);
+        auto found = stamps[s].find(path);
+        if(found != stamps[s].end())
+            return found->second;
+    }
+
+    //stat is done without holding the lock, two threads may both stat a file but get the first stamp,
+    //which was taken before either read the file
+    std::pair<long long int, long long int> pathStamp = file_stamp(path);
+    noStats++;
+
+    std::lock_guard<std::mutex> lock(mtxs[s]);
+    return stamps[s].insert(std::make_pair(path, pathStamp)).first->second;
+}
+
+bool StatCache::exists(const std::string& path)
+{
+    return stamp(path).second >= 0;
+}
+
+bool StatCache::modified_after(const Path& path1, const Path& path2)
+{
+    return stamp(path1.str()).second > stamp(path2.str()).second;
+}
+
+unsigned long long int StatCache::hash(const std::string& path, const std::pair<long long int, long long int>& pathStamp)
+{
+    size_t s = std::hash<std::string>()(path) % noShards;
+
+    {
+        std::lock_guard<std::mutex> lock(mtxs[s]);
+        auto found = hashes[s].find(path);
+        if(found != hashes[s].end() && found->second.first == pathStamp)
+            return found->second.second;
+    }
+
+    unsigned long long int pathHash = file_hash(path);
+    noHashes++;
+
+    //the file changed since it was stamped, so the hash isn't of the contents it had then
+    if(file_stamp(path) != pathStamp)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(mtxs[s]);
+    hashes[s][path] = std::make_pair(pathStamp, pathHash);
+
+    return pathHash;
+}
+
+//read in text mode, the same as the ifstreams pages used to be built from
+int read_text(const std::string& path, std::string& fileContents)
+{
+    std::ifstream ifs(path);
+    if(!ifs)
+        return 1;
+
+    fileContents.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+
+    return 0;
+}
+
+int StatCache::read(const std::string& path, std::string& fileContents)
+{
+    if(!cacheContents)
+        return read_text(path, fileContents);
+
+    size_t s = std::hash<std::string>()(path) % noShards;
+    std::pair<long long int, long long int> pathStamp = stamp(path);
+    if(pathStamp.second < 0)
+        return 1;
+
+    {
+        std::lock_guard<std::mutex> lock(mtxs[s]);
+        auto found = contents[s].find(path);
+        if(found != contents[s].end() && found->second.first == pathStamp)
+        {
+            fileContents = found->second.second;
+            return 0;
+        }
+    }
+
+    if(read_text(path, fileContents))
+        return 1;
+
+    //the file changed since it was stamped, so the contents aren't the ones it had then
+    if(file_stamp(path) != pathStamp)
+        return 0;
+
+    std::lock_guard<std::mutex> lock(mtxs[s]);
+    auto found = contents[s].find(path);
+    if(found != contents[s].end())
+    {
+        contentsSize -= found->second.second.size();
+        contents[s].erase(found);
+    }
+    if(contentsSize + fileContents.size() <= maxContentsSize)
+    {
+        contents[s][path] = std::make_pair(pathStamp, fileContents);
+        contentsSize += fileContents.size();
+    }
+
+    return 0;
+}
@@ -0,0 +1,49 @@
+#ifndef STAT_CACHE_H_
+#define STAT_CACHE_H_
+
+#include <atomic>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+
+#include "FileSystem.h"
+
+/*
+    memoizes file_stamp (and file_hash) for the duration of a build pass, so
+    files many pages depend on (templates, partials etc.) are only stat'ed once.
+    shared between threads, the map is split in to separately locked
+    shards so threads checking different files rarely wait on each other.
+    when cacheContents is set (eg. by the daemon) file contents are kept
+    between build passes and only reread when their stamp changes
+*/
+struct StatCache
+{
+    static const int noShards = 16;
+
+    std::mutex mtxs[noShards];
+    std::unordered_map<std::string, std::pair<long long int, long long int> > stamps[noShards];
+    std::unordered_map<std::string, std::pair<std::pair<long long int, long long int>, unsigned long long int> > hashes[noShards];
+    std::unordered_map<std::string, std::pair<std::pair<long long int, long long int>, std::string> > contents[noShards];
+    std::atomic<long long int> noLookups, noStats, noHashes;
+    bool cacheContents;
+    size_t maxContentsSize; //files aren't added once the cached contents reach this size
+    std::atomic<size_t> contentsSize;
+
+    StatCache();
+
+    void clear();
+
+    std::pair<long long int, long long int> stamp(const std::string& path);
+    bool exists(const std::string& path);
+    bool modified_after(const Path& path1, const Path& path2);
+
+    //content hash of a file with the given stamp, only rehashed when its stamp changes
+    unsigned long long int hash(const std::string& path, const std::pair<long long int, long long int>& pathStamp);
+    //reads a file's contents (from the cache if it has the same stamp as when cached), returns 1 if it can't be read
+    int read(const std::string& path, std::string& fileContents);
+};
+
+//cleared at the start of each build pass
+extern StatCache statCache;
+
+#endif //STAT_CACHE_H_
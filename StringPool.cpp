@@ -0,0 +1,136 @@
+#include "StringPool.h"
+
+StringPool stringPool;
+
+static const StringPool::Entry emptyEntry = {"", 0};
+
+//entry of a shard's index, only while holding the shard's lock
+static const StringPool::Entry& entry_in(const StringPool::Shard& shard, const size_t& index)
+{
+    return shard.chunks[index / StringPool::chunkSize].load(std::memory_order_relaxed)[index % StringPool::chunkSize];
+}
+
+StringPool::StringPool()
+{
+    for(int s=0; s<noShards; s++)
+    {
+        shards[s].noStrings = 0;
+        shards[s].block = NULL;
+        shards[s].blockPos = blockSize;
+        for(size_t c=0; c<maxChunks; c++)
+            shards[s].chunks[c] = NULL;
+    }
+}
+
+StringID StringPool::intern(const char* str, const size_t& size)
+{
+    if(!size)
+        return 0;
+
+    unsigned long long int hash = fnv1a(str, size);
+    int shardNo = hash % noShards;
+    Shard& shard = shards[shardNo];
+
+    std::lock_guard<std::mutex> lock(shard.mtx);
+
+    if(shard.slots.size())
+    {
+        size_t mask = shard.slots.size() - 1;
+        for(size_t s = ((StringID)hash / noShards) & mask; shard.slots[s].index; s = (s + 1) & mask)
+        {
+            if(shard.slots[s].hash != (StringID)hash)
+                continue;
+
+            size_t index = shard.slots[s].index - 1;
+            const Entry& cEntry = entry_in(shard, index);
+            if(cEntry.size == size && !std::memcmp(cEntry.str, str, size))
+                return index*noShards + shardNo + 1;
+        }
+    }
+
+    //keeps the hash table at most half full
+    if(2*(shard.noStrings + 1) > shard.slots.size())
+    {
+        std::vector<Slot> slots(shard.slots.size() ? 2*shard.slots.size() : 1024, Slot());
+        size_t mask = slots.size() - 1;
+        for(size_t o=0; o<shard.slots.size(); o++)
+        {
+            if(!shard.slots[o].index)
+                continue;
+
+            size_t s = (shard.slots[o].hash / noShards) & mask;
+            while(slots[s].index)
+                s = (s + 1) & mask;
+            slots[s] = shard.slots[o];
+        }
+        shard.slots.swap(slots);
+    }
+
+    //copies the string (null terminated) in to the current block, long strings get a block of their own
+    char* copy;
+    if(size + 1 > blockSize/16)
+    {
+        copy = new char[size + 1];
+        shard.blocks.push_back(copy);
+    }
+    else
+    {
+        if(shard.blockPos + size + 1 > blockSize)
+        {
+            shard.block = new char[blockSize];
+            shard.blocks.push_back(shard.block);
+            shard.blockPos = 0;
+        }
+        copy = shard.block + shard.blockPos;
+        shard.blockPos += size + 1;
+    }
+    std::memcpy(copy, str, size);
+    copy[size] = '\0';
+
+    size_t index = shard.noStrings++;
+    Entry* chunk = shard.chunks[index / chunkSize].load(std::memory_order_relaxed);
+    if(!chunk)
+        chunk = new Entry[chunkSize];
+    chunk[index % chunkSize].str = copy;
+    chunk[index % chunkSize].size = size;
+    shard.chunks[index / chunkSize].store(chunk, std::memory_order_release);
+
+    size_t mask = shard.slots.size() - 1;
+    size_t s = ((StringID)hash / noShards) & mask;
+    while(shard.slots[s].index)
+        s = (s + 1) & mask;
+    shard.slots[s].index = index + 1;
+    shard.slots[s].hash = (StringID)hash;
+
+    return index*noShards + shardNo + 1;
+}
+
+StringID StringPool::intern(const std::string& str)
+{
+    return intern(str.c_str(), str.size());
+}
+
+const StringPool::Entry& StringPool::entry(const StringID& id) const
+{
+    if(!id)
+        return emptyEntry;
+
+    size_t index = (id - 1) / noShards;
+    return shards[(id - 1) % noShards].chunks[index / chunkSize].load(std::memory_order_acquire)[index % chunkSize];
+}
+
+std::string StringPool::str(const StringID& id) const
+{
+    const Entry& cEntry = entry(id);
+    return std::string(cEntry.str, cEntry.size);
+}
+
+const char* StringPool::c_str(const StringID& id) const
+{
+    return entry(id).str;
+}
+
+size_t StringPool::size(const StringID& id) const
+{
+    return entry(id).size;
+}
@@ -0,0 +1,73 @@
+#ifndef STRING_POOL_H_
+#define STRING_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Hash.h"
+
+typedef uint32_t StringID;
+
+/*
+    interns strings (directories and filenames of paths) so each distinct
+    string is kept once, in large blocks rather than separately allocated,
+    and referred to by a 32-bit id (0 is the empty string). shared between
+    threads, strings are added to separately locked shards by hash and
+    never move or get removed (the pool lives until nsm exits), so reading
+    a string by id doesn't lock
+*/
+struct StringPool
+{
+    static const int noShards = 16;
+    static const size_t chunkSize = 1 << 16; //entries per chunk
+    static const size_t maxChunks = 1 << 12; //chunks per shard, enough for 2^32 ids
+    static const size_t blockSize = 1 << 20; //bytes per block of strings
+
+    struct Entry
+    {
+        const char* str;
+        size_t size;
+    };
+
+    struct Slot
+    {
+        StringID index, //index in the shard + 1, 0 if empty
+                 hash; //low bits of the string's hash, so most mismatches don't need comparing
+
+        Slot()
+        {
+            index = hash = 0;
+        }
+    };
+
+    struct Shard
+    {
+        std::mutex mtx;
+        std::vector<Slot> slots; //hash table
+        size_t noStrings;
+        std::vector<char*> blocks;
+        char* block; //block strings are currently being added to
+        size_t blockPos;
+        std::atomic<Entry*> chunks[maxChunks];
+    };
+
+    Shard shards[noShards];
+
+    StringPool();
+
+    StringID intern(const char* str, const size_t& size);
+    StringID intern(const std::string& str);
+
+    const Entry& entry(const StringID& id) const;
+    std::string str(const StringID& id) const;
+    const char* c_str(const StringID& id) const;
+    size_t size(const StringID& id) const;
+};
+
+extern StringPool stringPool;
+
+#endif //STRING_POOL_H_
@@ -60,5 +60,28 @@
     };
 #endif
 
+/*
+    returns cpu time used by the calling thread in seconds,
+    returns -1 where per-thread cpu time isn't available
+*/
+#if defined _WIN32 || defined _WIN64
+    inline double threadCPUTime()
+    {
+        return -1;
+    };
+#else //Mac/Linux
+    #include <time.h>
+
+    inline double threadCPUTime()
+    {
+        #ifdef CLOCK_THREAD_CPUTIME_ID
+            timespec ts;
+            if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+                return ts.tv_sec+(ts.tv_nsec/1000000000.0);
+        #endif
+        return -1;
+    };
+#endif
+
 
 #endif //TIMER_H_
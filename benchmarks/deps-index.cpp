@@ -0,0 +1,73 @@
+//times opening a deps.index of no-pages pages, each depending on its content file, a
+//template and a few shared partials, with and without working out the pages of each dependency
+//run from an empty directory, .siteinfo/deps.index is written there first
+//usage: benchmarks/deps-index [no-pages] (default: 100000)
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#include "../DepIndex.h"
+
+double seconds_since(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    size_t noPages = (argc > 1) ? std::atol(argv[1]) : 100000;
+    char str[64];
+
+    if(mkdir(".siteinfo", 0755) && errno != EEXIST)
+    {
+        std::printf("error: could not create .siteinfo\n");
+        return 1;
+    }
+
+    DepIndex depIndex;
+    depIndex.hashDeps = 1;
+    for(size_t p=0; p<noPages; p++)
+    {
+        DepIndexEntry entry;
+        std::snprintf(str, 64, "dir%zu/page%zu", p/1000, p);
+        Name pageName = str;
+        entry.pageTitle.str = pageName;
+        entry.templatePath.set_file_path_from("template/page.template");
+        entry.outputHash = p + 1;
+        entry.pageStamp = entry.infoStamp = std::make_pair((long long int)p, 1600000000000000000LL);
+
+        std::snprintf(str, 64, "content/dir%zu/page%zu.content", p/1000, p);
+        entry.deps.resize(5);
+        entry.deps[0].set_file_path_from(str);
+        entry.deps[1] = entry.templatePath;
+        entry.deps[2].set_file_path_from("template/head.content");
+        entry.deps[3].set_file_path_from("template/menu.content");
+        std::snprintf(str, 64, "template/partial%zu.content", p%100);
+        entry.deps[4].set_file_path_from(str);
+        entry.depStamps.resize(entry.deps.size());
+        entry.depParents.assign(entry.deps.size(), -1);
+        for(size_t d=0; d<entry.deps.size(); d++)
+        {
+            entry.depStamps[d].stamp = std::make_pair((long long int)(100 + d), 1600000000000000000LL + (long long int)p);
+            entry.depStamps[d].hash = 1000003*p + d;
+        }
+
+        depIndex.update(pageName, entry);
+    }
+    depIndex.save(NULL);
+    std::printf("%zu pages, %zu dependencies each\n", noPages, (size_t)5);
+
+    for(int reverseIndex=0; reverseIndex<2; reverseIndex++)
+    {
+        DepIndex opened;
+        opened.reverseIndex = reverseIndex;
+
+        auto start = std::chrono::steady_clock::now();
+        opened.open();
+        std::printf("open%s: %.3fs (%zu pages, %zu dependencies)\n", reverseIndex ? " with reverse index" : "", seconds_since(start), opened.pages.size(), opened.reverse.size());
+    }
+
+    return 0;
+}
@@ -0,0 +1,29 @@
+#!/bin/bash
+# generates a site tracking a large number of pages by writing pages.list
+# directly (no content files), for timing commands which open every page
+#
+# usage: benchmarks/gen-site.sh nsm dir [no-pages]
+#   nsm       nsm binary used to initialise the site
+#   dir       directory to generate the site in (removed first)
+#   no-pages  number of pages to track (default: 1000000)
+#
+# pages are named 'dNNN/pNNNNNNN' spread over 1000 directories, which
+# gives a pages.list of 58 bytes per page
+
+NSM=$1
+DIR=$2
+NO_PAGES=${3:-1000000}
+[ -n "$NSM" ] && [ -n "$DIR" ] || { echo "usage: $0 nsm dir [no-pages]"; exit 1; }
+
+rm -rf "$DIR" && mkdir -p "$DIR" && cd "$DIR" || exit 1
+NSM_NO_DAEMON=1 "$NSM" init benchmark > /dev/null || exit 1
+
+#entries are written in the order pages.list is saved in
+awk -v n=$NO_PAGES 'BEGIN {
+    for(d=0; d<1000; d++)
+        for(p=d; p<n; p+=1000)
+        {
+            name = sprintf("'"'"'d%03d/p%07d'"'"'", d, p)
+            printf "%s\n%s\n'"'"'template/page.template'"'"'\n\n", name, name
+        }
+}' >> .siteinfo/pages.list
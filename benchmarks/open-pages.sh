@@ -0,0 +1,26 @@
+#!/bin/bash
+# times opening a site with a large pages.list, by untracking a page which
+# isn't tracked (every page is read before the error is given)
+#
+# usage: benchmarks/open-pages.sh [nsm] [no-pages]
+#   nsm       nsm binary to time (default: nsm on the PATH)
+#   no-pages  number of tracked pages (default: 1000000)
+
+NSM=$(command -v "${1:-nsm}") || { echo "error: cannot find nsm binary ${1:-nsm}"; exit 1; }
+NO_PAGES=${2:-1000000}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+export NSM_NO_DAEMON=1
+
+"$(dirname "$0")/gen-site.sh" "$NSM" "$DIR/site" $NO_PAGES || exit 1
+cd "$DIR/site" || exit 1
+echo "site tracking $NO_PAGES pages, $(wc -c < .siteinfo/pages.list) byte pages.list"
+
+best=""
+for run in 1 2 3; do
+    start=$(date +%s%N)
+    "$NSM" untrack not-a-tracked-page > /dev/null
+    t=$(( ($(date +%s%N) - start)/1000000 ))
+    [ -z "$best" ] || [ $t -lt $best ] && best=$t
+done
+printf "%-10s %6dms\n" "open:" $best
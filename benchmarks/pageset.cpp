@@ -0,0 +1,82 @@
+//times finds, churn and in order insertion/iteration on PageSet against std::set<PageInfo>
+//usage: benchmarks/pageset [no-pages] (default: 1000000)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+
+#include "../PageSet.h"
+
+double seconds_since(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+//pages are added in order, as when reading pages.list
+void insert_page(std::set<PageInfo>& set, const PageInfo& page)
+{
+    set.insert(set.end(), page);
+}
+
+void insert_page(PageSet& set, const PageInfo& page)
+{
+    set.insert(page);
+}
+
+template <class Set>
+void time_set(const char* setName, const std::vector<PageInfo>& pages, const std::vector<PageInfo>& probes)
+{
+    auto start = std::chrono::steady_clock::now();
+    Set set;
+    for(size_t p=0; p<pages.size(); p++)
+        insert_page(set, pages[p]);
+    size_t count = 0;
+    for(auto page=set.begin(); page!=set.end(); page++)
+        count += page->pageName.size();
+    std::printf("%-9s %-30s %7.3fs\n", setName, "in order insert + iterate", seconds_since(start));
+
+    start = std::chrono::steady_clock::now();
+    for(size_t p=0; p<probes.size(); p++)
+        count += set.find(probes[p])->pageTitle.str.size();
+    std::printf("%-9s %-30s %7.3fs\n", setName, (std::to_string(probes.size()) + " random finds").c_str(), seconds_since(start));
+
+    start = std::chrono::steady_clock::now();
+    size_t noChurn = std::min((size_t)10000, probes.size());
+    for(size_t p=0; p<noChurn; p++)
+        set.erase(probes[p]);
+    for(size_t p=0; p<noChurn; p++)
+        set.insert(probes[p]);
+    for(auto page=set.begin(); page!=set.end(); page++)
+        count++;
+    std::printf("%-9s %-30s %7.3fs\n", setName, (std::to_string(noChurn) + " erase/insert + iterate").c_str(), seconds_since(start));
+
+    if(count == 0)
+        std::printf("\n");
+}
+
+int main(int argc, char* argv[])
+{
+    size_t noPages = (argc > 1) ? std::atol(argv[1]) : 1000000;
+    std::vector<PageInfo> pages(noPages);
+    char name[64];
+
+    for(size_t p=0; p<noPages; p++)
+    {
+        std::snprintf(name, sizeof(name), "dir%03zu/page%07zu", p%1000, p);
+        pages[p].pageName = name;
+        pages[p].pageTitle.str = name;
+        pages[p].pagePath.set_file_path_from(std::string("site/") + name + ".html");
+    }
+    std::sort(pages.begin(), pages.end());
+
+    std::vector<PageInfo> probes(pages);
+    std::shuffle(probes.begin(), probes.end(), std::mt19937(1));
+
+    time_set<std::set<PageInfo> >("std::set", pages, probes);
+    time_set<PageSet>("PageSet", pages, probes);
+
+    return 0;
+}
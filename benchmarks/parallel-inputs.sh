@@ -0,0 +1,49 @@
+#!/bin/bash
+# times building a large page made of a run of big @input siblings, rendered
+# in order and then with parallelInputs set
+#
+# usage: benchmarks/parallel-inputs.sh [nsm] [no-inputs] [lines-per-input]
+#   nsm              nsm binary to time (default: nsm on the PATH)
+#   no-inputs        number of consecutive @input lines on the page (default: 64)
+#   lines-per-input  lines in each input file (default: 20000)
+
+NSM=$(command -v "${1:-nsm}") || { echo "error: cannot find nsm binary ${1:-nsm}"; exit 1; }
+NO_INPUTS=${2:-64}
+NO_LINES=${3:-20000}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+export NSM_NO_DAEMON=1
+
+#generates the site
+cd "$DIR" && "$NSM" init benchmark > /dev/null || exit 1
+mkdir -p template/parts
+cat > template/parts/row.content <<'T'
+<td>@pagetitle</td>
+T
+for ((i=0; i<NO_INPUTS; i++)); do
+    awk -v i=$i -v n=$NO_LINES 'BEGIN { for(l=0; l<n; l++) printf "<tr><td>part %d row %d</td>@input(template/parts/row.content)</tr>\n", i, l }' > template/parts/part$i.content
+    echo "@input(template/parts/part$i.content)"
+done > content/index.content
+cp .siteinfo/nsm.config nsm.config.serial
+
+#prints the best of three build-all runs
+time_build()
+{
+    local best=""
+    for run in 1 2 3; do
+        rm -rf site .siteinfo/site .siteinfo/deps.index
+        local start=$(date +%s%N)
+        "$NSM" build-all > /dev/null || { echo "error: build-all failed"; exit 1; }
+        local t=$(( ($(date +%s%N) - start)/1000000 ))
+        [ -z "$best" ] || [ $t -lt $best ] && best=$t
+    done
+    printf "%-10s %6dms\n" "$1:" $best
+}
+
+echo "page with $NO_INPUTS inputs of $NO_LINES lines each, $(nproc) cores"
+cp nsm.config.serial .siteinfo/nsm.config
+time_build "in order"
+cp site/index.html index.serial.html
+( cat nsm.config.serial; printf 'parallelInputs 1\n' ) > .siteinfo/nsm.config
+time_build "parallel"
+cmp -s site/index.html index.serial.html || { echo "error: outputs differ"; exit 1; }
@@ -0,0 +1,61 @@
+//times inserting paths in to a std::set and checking paths for equality,
+//comparing Paths directly against comparing their comparableStr() (how Paths used to be compared)
+//usage: benchmarks/paths [no-paths] (default: 1000000)
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+
+#include "../Path.h"
+
+double seconds_since(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct StrLess
+{
+    bool operator()(const Path& path1, const Path& path2) const
+    {
+        return path1.comparableStr() < path2.comparableStr();
+    }
+};
+
+int main(int argc, char* argv[])
+{
+    size_t noPaths = (argc > 1) ? std::atol(argv[1]) : 1000000;
+    std::vector<Path> paths(noPaths);
+    char pathStr[64];
+
+    //some paths start with ./ so aren't the same ids as the equivalent path without it
+    for(size_t p=0; p<noPaths; p++)
+    {
+        std::snprintf(pathStr, sizeof(pathStr), "%scontent/d%zu/p%07zu.content", (p%7) ? "" : "./", p%300, p);
+        paths[p].set_file_path_from(pathStr);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::set<Path, StrLess> strSet(paths.begin(), paths.end());
+    std::printf("%-26s %7.3fs\n", "comparableStr set insert", seconds_since(start));
+
+    start = std::chrono::steady_clock::now();
+    std::set<Path> pathSet(paths.begin(), paths.end());
+    std::printf("%-26s %7.3fs\n", "Path set insert", seconds_since(start));
+
+    size_t count = 0;
+    start = std::chrono::steady_clock::now();
+    for(size_t p=0; p+1<noPaths; p++)
+        count += (paths[p].comparableStr() == paths[p+1].comparableStr()) + (paths[p].comparableStr() == paths[p].comparableStr());
+    std::printf("%-26s %7.3fs\n", "comparableStr equality", seconds_since(start));
+
+    start = std::chrono::steady_clock::now();
+    for(size_t p=0; p+1<noPaths; p++)
+        count += (paths[p] == paths[p+1]) + (paths[p] == paths[p]);
+    std::printf("%-26s %7.3fs\n", "Path equality", seconds_since(start));
+
+    if(count != 2*(noPaths-1) || strSet.size() != pathSet.size())
+        std::printf("error: comparisons disagree\n");
+
+    return 0;
+}
@@ -0,0 +1,33 @@
+#!/bin/bash
+# times and gives the peak memory use of commands which read every tracked
+# page, on a site tracking a large number of pages
+#
+# usage: benchmarks/site-commands.sh [nsm] [no-pages]
+#   nsm       nsm binary to time (default: nsm on the PATH)
+#   no-pages  number of tracked pages (default: 1000000)
+#
+# needs python3 for the peak resident set size of each command
+
+NSM=$(command -v "${1:-nsm}") || { echo "error: cannot find nsm binary ${1:-nsm}"; exit 1; }
+NO_PAGES=${2:-1000000}
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+export NSM_NO_DAEMON=1
+
+"$(dirname "$0")/gen-site.sh" "$NSM" "$DIR/site" $NO_PAGES || exit 1
+cd "$DIR/site" || exit 1
+echo "site tracking $NO_PAGES pages"
+
+#prints time taken and peak resident set size of running nsm with the given arguments
+run()
+{
+    python3 - "$NSM" "$@" <<'P'
+import resource, subprocess, sys, time
+start = time.time()
+subprocess.call(sys.argv[1:], stdout=subprocess.DEVNULL)
+print("%-12s %8.0fms %8dMB" % (" ".join(sys.argv[2:]) + ":", (time.time() - start)*1000, resource.getrusage(resource.RUSAGE_CHILDREN).ru_maxrss//1024))
+P
+}
+
+run info-names
+run status
@@ -10,6 +10,7 @@
     https://n-ham.com
 */
 
+#include "Daemon.h"
 #include "GitInfo.h"
 #include "SiteInfo.h"
 #include "Timer.h"
@@ -52,6 +53,26 @@ bool isNum(const std::string& str)
     return 1;
 }
 
+//parses shard options of the form --shard i/n or --shard-cost i/n
+int set_shard(SiteInfo& site, const std::string& option, const std::string& shardStr)
+{
+    if(option != "--shard" && option != "--shard-cost")
+    {
+        std::cout << "error: unrecognised option '" << option << "', expected --shard or --shard-cost" << std::endl;
+        return 1;
+    }
+
+    size_t pos = shardStr.find_first_of('/');
+    if(pos == std::string::npos || !isNum(shardStr.substr(0, pos)) || !isNum(shardStr.substr(pos+1)) ||
+       pos == 0 || pos+1 == shardStr.size())
+    {
+        std::cout << "error: shard should be of the form i/n, eg. 2/4" << std::endl;
+        return 1;
+    }
+
+    return site.set_shard(std::stoi(shardStr.substr(0, pos)), std::stoi(shardStr.substr(pos+1)), option == "--shard-cost");
+}
+
 int serve()
 {
     std::ofstream ofs;
@@ -89,6 +110,52 @@ void unrecognisedCommand(const std::string from, const std::string cmd)
     std::cout << "error: " << from << " does not recognise the command '" << cmd << "'" << std::endl;
 }
 
+//reads page specs for the -many commands, one per line, from a file or stdin (specsPath "-")
+int read_specs(const std::string& specsPath, const size_t& minParams, const size_t& maxParams, std::vector<std::vector<std::string> >& specs)
+{
+    std::string data, specsName = (specsPath == "-") ? "stdin" : quote(specsPath);
+
+    if(specsPath == "-")
+        data.assign((std::istreambuf_iterator<char>(std::cin)), std::istreambuf_iterator<char>());
+    else if(read_file(specsPath, data))
+    {
+        std::cout << "error: cannot open " << specsName << std::endl;
+        return 1;
+    }
+
+    const char *lineStart = data.c_str(),
+               *dataEnd = lineStart + data.size(),
+               *lineEnd, *pos;
+    std::string param;
+    for(size_t lineNo=1; lineStart < dataEnd; lineStart = lineEnd + 1, lineNo++)
+    {
+        lineEnd = std::find(lineStart, dataEnd, '\n');
+        pos = lineStart;
+
+        std::vector<std::string> spec;
+        while(read_quoted(pos, lineEnd, param))
+            spec.push_back(param);
+
+        //skips blank lines
+        if(!spec.size())
+            continue;
+
+        if(spec.size() < minParams || spec.size() > maxParams)
+        {
+            std::cout << "error: " << specsName << ": line " << lineNo << " has " << spec.size() << " parameters, expected ";
+            if(minParams == maxParams)
+                std::cout << minParams << std::endl;
+            else
+                std::cout << minParams << "-" << maxParams << std::endl;
+            return 1;
+        }
+
+        specs.push_back(spec);
+    }
+
+    return 0;
+}
+
 bool parError(int noParams, char* argv[], const std::string &expectedNo)
 {
     std::cout << "error: " << noParams << " parameters is not the " << expectedNo << " parameters expected" << std::endl;
@@ -138,17 +205,25 @@ int main(int argc, char* argv[])
         std::cout << "| pull           | pull remote changes locally                     |" << std::endl;
         std::cout << "| init           | initialise managing a site - input: (site-name) |" << std::endl;
         std::cout << "| status         | lists updated and problem pages                 |" << std::endl;
+        std::cout << "| explain        | input: page-name (--json)                       |" << std::endl;
         std::cout << "| info           | input: page-name-1 .. page-name-k               |" << std::endl;
         std::cout << "| info-all       | lists tracked pages                             |" << std::endl;
-        std::cout << "| info-names     | lists tracked page names                        |" << std::endl;
+        std::cout << "| info-names     | lists tracked page names - input: (prefix)      |" << std::endl;
         std::cout << "| track          | input: page-name (page-title) (template-path)   |" << std::endl;
         std::cout << "| untrack        | input: page-name                                |" << std::endl;
         std::cout << "| rm or del      | input: page-name                                |" << std::endl;
         std::cout << "| mv or move     | input: old-name new-name                        |" << std::endl;
         std::cout << "| cp or copy     | input: tracked-name new-name                    |" << std::endl;
+        std::cout << "| track-many     | input: (specs-path), name (title) (template)    |" << std::endl;
+        std::cout << "| untrack-many   | input: (specs-path), page-name per line         |" << std::endl;
+        std::cout << "| rm-many        | input: (specs-path), page-name per line         |" << std::endl;
+        std::cout << "| mv-many        | input: (specs-path), old-name new-name per line |" << std::endl;
+        std::cout << "| cp-many        | input: (specs-path), tracked-name new-name      |" << std::endl;
         std::cout << "| build          | input: page-name-1 .. page-name-k               |" << std::endl;
-        std::cout << "| build-updated  | builds updated pages                            |" << std::endl;
-        std::cout << "| build-all      | builds all tracked pages                        |" << std::endl;
+        std::cout << "| build-updated  | builds updated pages (--shard i/n) (--dry-run)  |" << std::endl;
+        std::cout << "| build-all      | builds all pages (--shard i/n) (--stream)       |" << std::endl;
+        std::cout << "| merge-shards   | input: no-shards                                |" << std::endl;
+        std::cout << "| daemon         | keeps site open for requests - (stop)           |" << std::endl;
         std::cout << "| serve          | serves website locally                          |" << std::endl;
         std::cout << "| bcp            | input: commit-message                           |" << std::endl;
         std::cout << "| new-title      | input: page-name new-title                      |" << std::endl;
@@ -158,7 +233,7 @@ int main(int argc, char* argv[])
         std::cout << "| new-cont-ext   | input: (page-name) content-extension            |" << std::endl;
         std::cout << "| new-page-ext   | input: (page-name) page-extension               |" << std::endl;
         std::cout << "| new-script-ext | input: (page-name) script-extension             |" << std::endl;
-        std::cout << "| no-build-thrds | input: (no-threads) [-n == n*cores]             |" << std::endl;
+        std::cout << "| no-build-thrds | input: (no-threads) [-n == n*cores] or auto     |" << std::endl;
         std::cout << "+------------------------------------------------------------------+" << std::endl;
 
         return 0;
@@ -262,6 +337,7 @@ int main(int argc, char* argv[])
         ofs << "scriptExt '.py'" << std::endl;
         ofs << "defaultTemplate 'template/page.template'" << std::endl << std::endl;
         ofs << "buildThreads -1" << std::endl << std::endl;
+        ofs << "pagesListVersion 2" << std::endl << std::endl;
         ofs << "unixTextEditor nano" << std::endl;
         ofs << "winTextEditor notepad" << std::endl << std::endl;
         ofs << "rootBranch '##unset##'" << std::endl;
@@ -593,6 +669,7 @@ int main(int argc, char* argv[])
            cmd != "diff" &&
            cmd != "pull" &&
            cmd != "status" &&
+           cmd != "explain" &&
            cmd != "info" &&
            cmd != "info-all" &&
            cmd != "info-names" &&
@@ -604,6 +681,11 @@ int main(int argc, char* argv[])
            cmd != "move" &&
            cmd != "cp" &&
            cmd != "copy" &&
+           cmd != "track-many" &&
+           cmd != "untrack-many" &&
+           cmd != "rm-many" &&
+           cmd != "mv-many" &&
+           cmd != "cp-many" &&
            cmd != "new-title" &&
            cmd != "new-template" &&
            cmd != "new-site-dir" &&
@@ -615,6 +697,8 @@ int main(int argc, char* argv[])
            cmd != "build-updated" &&
            cmd != "build" &&
            cmd != "build-all" &&
+           cmd != "merge-shards" &&
+           cmd != "daemon" &&
            cmd != "serve")
         {
             unrecognisedCommand("nsm", cmd);
@@ -700,6 +784,49 @@ int main(int argc, char* argv[])
             return 0;
         }
 
+        if(cmd == "daemon")
+        {
+            //ensures correct number of parameters given
+            if(noParams == 2 && std::string(argv[2]) == "stop")
+                return stop_daemon();
+            else if(noParams != 1)
+                return parError(noParams, argv, "1 or 2");
+
+            return run_daemon();
+        }
+
+        //hands requests the daemon can answer over to it when one is running
+        if((cmd == "build" && noParams > 1) ||
+           (cmd == "build-updated" && noParams == 1) ||
+           (cmd == "status" && noParams == 1) ||
+           (cmd == "info" && noParams > 1))
+        {
+            if(!daemon_request(argc, argv, ret_val))
+            {
+                if(cmd == "build" || cmd == "build-updated")
+                {
+                    std::cout.precision(4);
+                    std::cout << "time taken: " << timer.getTime() << " seconds" << std::endl;
+                }
+
+                return ret_val;
+            }
+        }
+        else if(cmd != "status" &&
+                cmd != "explain" &&
+                cmd != "info" &&
+                cmd != "info-all" &&
+                cmd != "info-names" &&
+                cmd != "build" &&
+                cmd != "build-updated" &&
+                cmd != "build-all" &&
+                cmd != "merge-shards" &&
+                cmd != "serve")
+        {
+            //lets a running daemon know to reopen the site once this command has finished
+            std::atexit(notify_daemon);
+        }
+
         SiteInfo site;
         if(site.open_config())
             return 1;
@@ -707,7 +834,7 @@ int main(int argc, char* argv[])
         //Nift commands that need site information file open
         if(cmd == "config")
         {
-            if(site.buildThreads < 0)
+            if(site.buildThreads < 0 && !site.autoBuildThreads)
                 site.buildThreads = -site.buildThreads*std::thread::hardware_concurrency();
 
             std::cout << "contentDir: " << quote(site.contentDir) << std::endl;
@@ -716,7 +843,18 @@ int main(int argc, char* argv[])
             std::cout << "pageExt: " << quote(site.pageExt) << std::endl;
             std::cout << "scriptExt: " << quote(site.scriptExt) << std::endl;
             std::cout << "defaultTemplate: " << site.defaultTemplate << std::endl << std::endl;
-            std::cout << "buildThreads: " << site.buildThreads << std::endl << std::endl;
+            if(site.autoBuildThreads)
+                std::cout << "buildThreads: auto" << std::endl << std::endl;
+            else
+                std::cout << "buildThreads: " << site.buildThreads << std::endl << std::endl;
+            if(site.parallelInputs)
+                std::cout << "parallelInputs: " << site.parallelInputs << std::endl << std::endl;
+            if(site.hashDeps)
+                std::cout << "hashDeps: 1" << std::endl << std::endl;
+            if(site.buildState)
+                std::cout << "buildState: 1" << std::endl << std::endl;
+            if(site.buildTime != "")
+                std::cout << "buildTime: " << site.buildTime << std::endl << std::endl;
             std::cout << "unixTextEditor: " << quote(site.unixTextEditor) << std::endl;
             std::cout << "winTextEditor: " << quote(site.winTextEditor) << std::endl << std::endl;
             std::cout << "rootBranch: " << quote(site.rootBranch) << std::endl;
@@ -851,12 +989,19 @@ int main(int argc, char* argv[])
                 return parError(noParams, argv, "1 or 2");
 
             if(noParams == 1)
-                std::cout << site.buildThreads << std::endl;
+            {
+                if(site.autoBuildThreads)
+                    std::cout << "auto" << std::endl;
+                else
+                    std::cout << site.buildThreads << std::endl;
+            }
+            else if(std::string(argv[2]) == "auto")
+                return site.auto_build_threads();
             else
             {
                 if(!isNum(std::string(argv[2])))
                 {
-                    std::cout << "error: number of build threads should be a non-zero integer (use negative numbers for a multiple of the number of cores on the machine)" << std::endl;
+                    std::cout << "error: number of build threads should be a non-zero integer (use negative numbers for a multiple of the number of cores on the machine) or auto" << std::endl;
                     return 1;
                 }
                 return site.no_build_threads(std::stoi(std::string(argv[2])));
@@ -865,6 +1010,73 @@ int main(int argc, char* argv[])
             return 0;
         }
 
+        //info and info-names only open the pages they need
+        if(cmd == "info")
+        {
+            //ensures correct number of parameters given
+            if(noParams <= 1)
+                return parError(noParams, argv, ">1");
+
+            std::vector<Name> pageNames;
+            for(int p=2; p<argc; p++)
+                pageNames.push_back(argv[p]);
+
+            if(site.open_pages(pageNames))
+                return 1;
+
+            return site.info(pageNames);
+        }
+        else if(cmd == "info-names")
+        {
+            //ensures correct number of parameters given
+            if(noParams > 2)
+                return parError(noParams, argv, "1 or 2");
+
+            return site.info_names(noParams == 2 ? argv[2] : "");
+        }
+        else if(cmd == "build-all")
+        {
+            //ensures correct number of parameters given
+            if(noParams > 3)
+                return parError(noParams, argv, "1-3");
+
+            //--stream builds pages in batches without opening every page
+            bool stream = (noParams == 2 && std::string(argv[2]) == "--stream");
+            if(noParams == 2 && !stream)
+            {
+                std::cout << "error: unrecognised option '" << argv[2] << "', expected --stream" << std::endl;
+                return 1;
+            }
+            else if(noParams == 3 && set_shard(site, argv[2], argv[3]))
+                return 1;
+
+            if(!stream && site.open_pages())
+                return 1;
+
+            //checks for pre-build scripts
+            if(run_script(std::cout, "pre-build" + site.scriptExt, &os_mtx2))
+                return 1;
+
+            //checks for pre-build-all scripts
+            if(run_script(std::cout, "pre-build-all" + site.scriptExt, &os_mtx2))
+                return 1;
+
+            int result = stream ? site.build_all_batched() : site.build_all();
+
+            //checks for post-build scripts
+            if(run_script(std::cout, "post-build" + site.scriptExt, &os_mtx2))
+                return 1;
+
+            //checks for post-build-all scripts
+            if(run_script(std::cout, "post-build-all" + site.scriptExt, &os_mtx2))
+                return 1;
+
+            std::cout.precision(4);
+            std::cout << "time taken: " << timer.getTime() << " seconds" << std::endl;
+
+            return result;
+        }
+
         //opens up pages.list file
         if(site.open_pages())
             return 1;
@@ -998,17 +1210,16 @@ int main(int argc, char* argv[])
 
             return site.status();
         }
-        else if(cmd == "info")
+        else if(cmd == "explain")
         {
             //ensures correct number of parameters given
-            if(noParams <= 1)
-                return parError(noParams, argv, ">1");
+            if(noParams != 2 && !(noParams == 3 && std::string(argv[3]) == "--json"))
+            {
+                std::cout << "error: correct usage 'explain page-name (--json)'" << std::endl;
+                return parError(noParams, argv, "2 or 3");
+            }
 
-            std::vector<Name> pageNames;
-            Name pageName;
-            for(int p=2; p<argc; p++)
-                pageNames.push_back(argv[p]);
-            return site.info(pageNames);
+            return site.explain(argv[2], noParams == 3);
         }
         else if(cmd == "info-all")
         {
@@ -1018,14 +1229,6 @@ int main(int argc, char* argv[])
 
             return site.info_all();
         }
-        else if(cmd == "info-names")
-        {
-            //ensures correct number of parameters given
-            if(noParams > 1)
-                return parError(noParams, argv, "1");
-
-            return site.info_names();
-        }
         else if(cmd == "track")
         {
             //ensures correct number of parameters given
@@ -1089,6 +1292,74 @@ int main(int argc, char* argv[])
 
             return site.cp(trackedPageName, newPageName);
         }
+        else if(cmd == "track-many")
+        {
+            //ensures correct number of parameters given
+            if(noParams > 2)
+                return parError(noParams, argv, "1-2");
+
+            //reads specs from stdin if no path (or -) given
+            std::vector<std::vector<std::string> > specs;
+            if(read_specs((noParams == 2) ? argv[2] : "-", 1, 3, specs))
+                return 1;
+
+            std::vector<Name> newPageNames(specs.size());
+            std::vector<Title> newPageTitles(specs.size());
+            std::vector<Path> newTemplatePaths(specs.size());
+            for(size_t p=0; p<specs.size(); p++)
+            {
+                newPageNames[p] = quote(specs[p][0]);
+                if(specs[p].size() >= 2)
+                    newPageTitles[p] = quote(specs[p][1]);
+                else
+                    newPageTitles[p] = get_title(newPageNames[p]);
+
+                if(specs[p].size() == 3)
+                    newTemplatePaths[p].set_file_path_from(specs[p][2]);
+                else
+                    newTemplatePaths[p] = site.defaultTemplate;
+            }
+
+            return site.track_many(newPageNames, newPageTitles, newTemplatePaths);
+        }
+        else if(cmd == "untrack-many" || cmd == "rm-many")
+        {
+            //ensures correct number of parameters given
+            if(noParams > 2)
+                return parError(noParams, argv, "1-2");
+
+            std::vector<std::vector<std::string> > specs;
+            if(read_specs((noParams == 2) ? argv[2] : "-", 1, 1, specs))
+                return 1;
+
+            std::vector<Name> pageNames(specs.size());
+            for(size_t p=0; p<specs.size(); p++)
+                pageNames[p] = specs[p][0];
+
+            if(cmd == "untrack-many")
+                return site.untrack_many(pageNames);
+            else
+                return site.rm_many(pageNames);
+        }
+        else if(cmd == "mv-many" || cmd == "cp-many")
+        {
+            //ensures correct number of parameters given
+            if(noParams > 2)
+                return parError(noParams, argv, "1-2");
+
+            std::vector<std::vector<std::string> > specs;
+            if(read_specs((noParams == 2) ? argv[2] : "-", 2, 2, specs))
+                return 1;
+
+            std::vector<std::pair<Name, Name> > moves(specs.size());
+            for(size_t m=0; m<specs.size(); m++)
+                moves[m] = std::make_pair(specs[m][0], specs[m][1]);
+
+            if(cmd == "mv-many")
+                return site.mv_many(moves);
+            else
+                return site.cp_many(moves);
+        }
         else if(cmd == "new-title")
         {
             //ensures correct number of parameters given
@@ -1216,9 +1487,23 @@ int main(int argc, char* argv[])
         }
         else if(cmd == "build-updated")
         {
+            //--dry-run just lists what needs building, without running scripts
+            int noShardParams = noParams;
+            if(noParams > 1 && std::string(argv[noParams]) == "--dry-run")
+            {
+                site.dryRun = 1;
+                noShardParams--;
+            }
+
             //ensures correct number of parameters given
-            if(noParams > 1)
-                return parError(noParams, argv, "1");
+            if(noShardParams != 1 && noShardParams != 3)
+                return parError(noParams, argv, "1 to 4");
+
+            if(noShardParams == 3 && set_shard(site, argv[2], argv[3]))
+                return 1;
+
+            if(site.dryRun)
+                return site.build_updated(std::cout);
 
             //checks for pre-build scripts
             if(run_script(std::cout, "pre-build" + site.scriptExt, &os_mtx2))
@@ -1270,34 +1555,19 @@ int main(int argc, char* argv[])
 
             return result;
         }
-        else if(cmd == "build-all")
+        else if(cmd == "merge-shards")
         {
             //ensures correct number of parameters given
-            if(noParams != 1)
-                return parError(noParams, argv, "1");
-
-            //checks for pre-build scripts
-            if(run_script(std::cout, "pre-build" + site.scriptExt, &os_mtx2))
-                return 1;
-
-            //checks for pre-build-all scripts
-            if(run_script(std::cout, "pre-build-all" + site.scriptExt, &os_mtx2))
-                return 1;
-
-            int result = site.build_all();
-
-            //checks for post-build scripts
-            if(run_script(std::cout, "post-build" + site.scriptExt, &os_mtx2))
-                return 1;
+            if(noParams != 2)
+                return parError(noParams, argv, "2");
 
-            //checks for post-build-all scripts
-            if(run_script(std::cout, "post-build-all" + site.scriptExt, &os_mtx2))
+            if(!isNum(argv[2]))
+            {
+                std::cout << "error: number of shards should be a positive integer" << std::endl;
                 return 1;
+            }
 
-            std::cout.precision(4);
-            std::cout << "time taken: " << timer.getTime() << " seconds" << std::endl;
-
-            return result;
+            return site.merge_shards(std::stoi(std::string(argv[2])));
         }
         else if(cmd == "serve")
         {